@@ -44,6 +44,7 @@
 #include <limits.h>
 #include <ctype.h>
 #include <float.h>
+#include <stdint.h>
 
 #ifdef ENABLE_LOCALES
 #include <locale.h>
@@ -81,17 +82,35 @@
 #define NAN 0.0/0.0
 #endif
 
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_THREADS__)
+#define CJSON_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__) || defined(__clang__)
+#define CJSON_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define CJSON_THREAD_LOCAL __declspec(thread)
+#else
+/* no thread local storage, the thread hooks and the error position are shared by all threads */
+#define CJSON_THREAD_LOCAL
+#endif
+
 typedef struct {
     const unsigned char *json;
     size_t position;
+    cJSON_bool limit; /* parsing stopped at a limit of cJSON_InitThreadLimits */
 } error;
-static error global_error = { NULL, 0 };
+/* position of the last parse error of the calling thread */
+static CJSON_THREAD_LOCAL error global_error = { NULL, 0, false };
 
 CJSON_PUBLIC(const char *) cJSON_GetErrorPtr(void)
 {
     return (const char*) (global_error.json + global_error.position);
 }
 
+CJSON_PUBLIC(cJSON_bool) cJSON_GetErrorLimit(void)
+{
+    return global_error.limit;
+}
+
 CJSON_PUBLIC(char *) cJSON_GetStringValue(const cJSON * const item) 
 {
     if (!cJSON_IsString(item)) 
@@ -112,6 +131,82 @@ CJSON_PUBLIC(double) cJSON_GetNumberValue(const cJSON * const item)
     return item->valuedouble;
 }
 
+/* 2^63 and 2^64 as double */
+#define INT64_LIMIT 9223372036854775808.0
+#define UINT64_LIMIT 18446744073709551616.0
+
+/* check if valueint64 holds the exact value, valuedouble might have been changed without updating it */
+static cJSON_bool number_has_int64(const cJSON * const item)
+{
+    if (!(item->type & cJSON_NumberIsInt))
+    {
+        return false;
+    }
+    if ((item->valuedouble == 0) && signbit(item->valuedouble))
+    {
+        /* -0 */
+        return false;
+    }
+    if (item->type & cJSON_NumberIsUint)
+    {
+        return (double)(uint64_t)item->valueint64 == item->valuedouble;
+    }
+
+    return (double)item->valueint64 == item->valuedouble;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_GetInt64Value(const cJSON * const item, int64_t * const value)
+{
+    if (!cJSON_IsNumber(item) || (value == NULL))
+    {
+        return false;
+    }
+
+    if (number_has_int64(item))
+    {
+        if (item->type & cJSON_NumberIsUint)
+        {
+            return false;
+        }
+        *value = item->valueint64;
+        return true;
+    }
+
+    if ((item->valuedouble >= -INT64_LIMIT) && (item->valuedouble < INT64_LIMIT) && (floor(item->valuedouble) == item->valuedouble))
+    {
+        *value = (int64_t)item->valuedouble;
+        return true;
+    }
+
+    return false;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_GetUint64Value(const cJSON * const item, uint64_t * const value)
+{
+    if (!cJSON_IsNumber(item) || (value == NULL))
+    {
+        return false;
+    }
+
+    if (number_has_int64(item))
+    {
+        if (!(item->type & cJSON_NumberIsUint) && (item->valueint64 < 0))
+        {
+            return false;
+        }
+        *value = (uint64_t)item->valueint64;
+        return true;
+    }
+
+    if ((item->valuedouble >= 0) && (item->valuedouble < UINT64_LIMIT) && (floor(item->valuedouble) == item->valuedouble))
+    {
+        *value = (uint64_t)item->valuedouble;
+        return true;
+    }
+
+    return false;
+}
+
 /* This is a safeguard to prevent copy-pasters from using incompatible C and header files */
 #if (CJSON_VERSION_MAJOR != 1) || (CJSON_VERSION_MINOR != 7) || (CJSON_VERSION_PATCH != 14)
     #error cJSON.h and cJSON.c have different versions. Make sure that both have the same.
@@ -181,6 +276,17 @@ static void * CJSON_CDECL internal_realloc(void *pointer, size_t size)
 
 static internal_hooks global_hooks = { internal_malloc, internal_free, internal_realloc };
 
+/* hooks of the calling thread set with cJSON_InitThreadHooks, unused while allocate is NULL */
+static CJSON_THREAD_LOCAL internal_hooks thread_hooks = { NULL, NULL, NULL };
+
+static const internal_hooks *current_hooks(void)
+{
+    return (thread_hooks.allocate != NULL) ? &thread_hooks : &global_hooks;
+}
+
+/* limits of the calling thread set with cJSON_InitThreadLimits, SIZE_MAX where there is none */
+static CJSON_THREAD_LOCAL cJSON_Limits thread_limits = { SIZE_MAX, CJSON_NESTING_LIMIT, SIZE_MAX, SIZE_MAX, SIZE_MAX };
+
 static unsigned char* cJSON_strdup(const unsigned char* string, const internal_hooks * const hooks)
 {
     size_t length = 0;
@@ -233,6 +339,92 @@ CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks)
     }
 }
 
+CJSON_PUBLIC(void) cJSON_InitThreadHooks(const cJSON_ThreadHooks* hooks)
+{
+    if (hooks == NULL)
+    {
+        /* back to the global hooks */
+        thread_hooks.allocate = NULL;
+        thread_hooks.deallocate = NULL;
+        thread_hooks.reallocate = NULL;
+        return;
+    }
+
+    thread_hooks.allocate = malloc;
+    if (hooks->malloc_fn != NULL)
+    {
+        thread_hooks.allocate = hooks->malloc_fn;
+    }
+
+    thread_hooks.deallocate = free;
+    if (hooks->free_fn != NULL)
+    {
+        thread_hooks.deallocate = hooks->free_fn;
+    }
+
+    /* use realloc only if both free and malloc are used */
+    thread_hooks.reallocate = hooks->realloc_fn;
+    if ((thread_hooks.reallocate == NULL) && (thread_hooks.allocate == malloc) && (thread_hooks.deallocate == free))
+    {
+        thread_hooks.reallocate = realloc;
+    }
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_GetThreadHooks(cJSON_ThreadHooks* hooks)
+{
+    if ((hooks == NULL) || (thread_hooks.allocate == NULL))
+    {
+        return false;
+    }
+
+    hooks->malloc_fn = thread_hooks.allocate;
+    hooks->free_fn = thread_hooks.deallocate;
+    hooks->realloc_fn = thread_hooks.reallocate;
+
+    return true;
+}
+
+static size_t limit_or_max(const size_t limit, const size_t max)
+{
+    return ((limit == 0) || (limit > max)) ? max : limit;
+}
+
+CJSON_PUBLIC(void) cJSON_InitThreadLimits(const cJSON_Limits* limits)
+{
+    static const cJSON_Limits none = { 0, 0, 0, 0, 0 };
+
+    if (limits == NULL)
+    {
+        limits = &none;
+    }
+
+    /* store the limits so that every check is a single comparison */
+    thread_limits.max_length = limit_or_max(limits->max_length, SIZE_MAX);
+    thread_limits.max_depth = limit_or_max(limits->max_depth, CJSON_NESTING_LIMIT);
+    thread_limits.max_members = limit_or_max(limits->max_members, SIZE_MAX);
+    thread_limits.max_elements = limit_or_max(limits->max_elements, SIZE_MAX);
+    thread_limits.max_string = limit_or_max(limits->max_string, SIZE_MAX);
+}
+
+static size_t limit_or_zero(const size_t limit, const size_t max)
+{
+    return (limit == max) ? 0 : limit;
+}
+
+CJSON_PUBLIC(void) cJSON_GetThreadLimits(cJSON_Limits* limits)
+{
+    if (limits == NULL)
+    {
+        return;
+    }
+
+    limits->max_length = limit_or_zero(thread_limits.max_length, SIZE_MAX);
+    limits->max_depth = limit_or_zero(thread_limits.max_depth, CJSON_NESTING_LIMIT);
+    limits->max_members = limit_or_zero(thread_limits.max_members, SIZE_MAX);
+    limits->max_elements = limit_or_zero(thread_limits.max_elements, SIZE_MAX);
+    limits->max_string = limit_or_zero(thread_limits.max_string, SIZE_MAX);
+}
+
 /* Internal constructor. */
 static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
 {
@@ -258,13 +450,13 @@ CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
         }
         if (!(item->type & cJSON_IsReference) && (item->valuestring != NULL))
         {
-            global_hooks.deallocate(item->valuestring);
+            current_hooks()->deallocate(item->valuestring);
         }
         if (!(item->type & cJSON_StringIsConst) && (item->string != NULL))
         {
-            global_hooks.deallocate(item->string);
+            current_hooks()->deallocate(item->string);
         }
-        global_hooks.deallocate(item);
+        current_hooks()->deallocate(item);
         item = next;
     }
 }
@@ -287,6 +479,8 @@ typedef struct
     size_t offset;
     size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
     internal_hooks hooks;
+    unsigned char *in_situ; /* writable alias of content when parsing in situ, NULL otherwise */
+    cJSON_bool limit; /* stopped at a limit of cJSON_InitThreadLimits rather than invalid input */
 } parse_buffer;
 
 /* check if the given size is left to read in a given parse buffer (starting with 1) */
@@ -297,883 +491,2787 @@ typedef struct
 /* get a pointer to the buffer at the position */
 #define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
 
-/* Parse the input text to generate a number, and populate the result into item. */
-static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
+/* SIMD scanning of string contents and whitespace, define CJSON_NO_SIMD to disable it */
+#if !defined(CJSON_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+#define CJSON_SIMD_SSE2
+#include <emmintrin.h>
+/* AVX2 is selected at runtime */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CJSON_SIMD_AVX2
+#include <immintrin.h>
+#endif
+#elif !defined(CJSON_NO_SIMD) && defined(__aarch64__) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define CJSON_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(CJSON_SIMD_SSE2) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/* scalar fallbacks, also used for the tails shorter than a vector */
+static size_t scalar_find_string_special(const unsigned char *input, size_t length)
 {
-    double number = 0;
-    unsigned char *after_end = NULL;
-    unsigned char number_c_string[64];
-    unsigned char decimal_point = get_decimal_point();
     size_t i = 0;
 
-    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+    while ((i < length) && (input[i] != '\"') && (input[i] != '\\'))
     {
-        return false;
+        i++;
     }
 
-    /* copy the number into a temporary buffer and replace '.' with the decimal point
-     * of the current locale (for strtod)
-     * This also takes care of '\0' not necessarily being available for marking the end of the input */
-    for (i = 0; (i < (sizeof(number_c_string) - 1)) && can_access_at_index(input_buffer, i); i++)
-    {
-        switch (buffer_at_offset(input_buffer)[i])
-        {
-            case '0':
-            case '1':
-            case '2':
-            case '3':
-            case '4':
-            case '5':
-            case '6':
-            case '7':
-            case '8':
-            case '9':
-            case '+':
-            case '-':
-            case 'e':
-            case 'E':
-                number_c_string[i] = buffer_at_offset(input_buffer)[i];
-                break;
-
-            case '.':
-                number_c_string[i] = decimal_point;
-                break;
+    return i;
+}
 
-            default:
-                goto loop_end;
-        }
-    }
-loop_end:
-    number_c_string[i] = '\0';
+static size_t scalar_find_non_whitespace(const unsigned char *input, size_t length)
+{
+    size_t i = 0;
 
-    number = strtod((const char*)number_c_string, (char**)&after_end);
-    if (number_c_string == after_end)
+    while ((i < length) && (input[i] <= 32))
     {
-        return false; /* parse_error */
+        i++;
     }
 
-    item->valuedouble = number;
+    return i;
+}
 
-    /* use saturation in case of overflow */
-    if (number >= INT_MAX)
-    {
-        item->valueint = INT_MAX;
-    }
-    else if (number <= (double)INT_MIN)
-    {
-        item->valueint = INT_MIN;
-    }
-    else
+static size_t scalar_find_escape(const unsigned char *input, size_t length)
+{
+    size_t i = 0;
+
+    while ((i < length) && (input[i] >= 32) && (input[i] != '\"') && (input[i] != '\\'))
     {
-        item->valueint = (int)number;
+        i++;
     }
 
-    item->type = cJSON_Number;
+    return i;
+}
 
-    input_buffer->offset += (size_t)(after_end - number_c_string);
-    return true;
+#ifdef CJSON_SIMD_SSE2
+static unsigned int trailing_zeros(unsigned int mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return (unsigned int)index;
+#else
+    return (unsigned int)__builtin_ctz(mask);
+#endif
 }
 
-/* don't ask me, but the original cJSON_SetNumberValue returns an integer or double */
-CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number)
+static size_t sse2_find_string_special(const unsigned char *input, size_t length)
 {
-    if (number >= INT_MAX)
-    {
-        object->valueint = INT_MAX;
-    }
-    else if (number <= (double)INT_MIN)
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    size_t i = 0;
+
+    for (; (i + 16) <= length; i += 16)
     {
-        object->valueint = INT_MIN;
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)(input + i));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+        if (mask != 0)
+        {
+            return i + trailing_zeros(mask);
+        }
     }
-    else
+
+    return i + scalar_find_string_special(input + i, length - i);
+}
+
+static size_t sse2_find_non_whitespace(const unsigned char *input, size_t length)
+{
+    const __m128i space = _mm_set1_epi8(32);
+    size_t i = 0;
+
+    for (; (i + 16) <= length; i += 16)
     {
-        object->valueint = (int)number;
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)(input + i));
+        /* max(c, 32) == 32 <=> c <= 32 */
+        unsigned int mask = ~(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(chunk, space), space)) & 0xFFFFu;
+        if (mask != 0)
+        {
+            return i + trailing_zeros(mask);
+        }
     }
 
-    return object->valuedouble = number;
+    return i + scalar_find_non_whitespace(input + i, length - i);
 }
 
-CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring)
+static size_t sse2_find_escape(const unsigned char *input, size_t length)
 {
-    char *copy = NULL;
-    /* if object's type is not cJSON_String or is cJSON_IsReference, it should not set valuestring */
-    if (!(object->type & cJSON_String) || (object->type & cJSON_IsReference))
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(31);
+    size_t i = 0;
+
+    for (; (i + 16) <= length; i += 16)
     {
-        return NULL;
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)(input + i));
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+        /* max(c, 31) == 31 <=> c < 32 */
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(special, _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control)));
+        if (mask != 0)
+        {
+            return i + trailing_zeros(mask);
+        }
     }
-    if (strlen(valuestring) <= strlen(object->valuestring))
+
+    return i + scalar_find_escape(input + i, length - i);
+}
+#endif /* CJSON_SIMD_SSE2 */
+
+#ifdef CJSON_SIMD_AVX2
+__attribute__((target("avx2")))
+static size_t avx2_find_string_special(const unsigned char *input, size_t length)
+{
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    size_t i = 0;
+
+    for (; (i + 32) <= length; i += 32)
     {
-        strcpy(object->valuestring, valuestring);
-        return object->valuestring;
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(const void*)(input + i));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)));
+        if (mask != 0)
+        {
+            return i + trailing_zeros(mask);
+        }
     }
-    copy = (char*) cJSON_strdup((const unsigned char*)valuestring, &global_hooks);
-    if (copy == NULL)
+
+    return i + sse2_find_string_special(input + i, length - i);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2_find_non_whitespace(const unsigned char *input, size_t length)
+{
+    const __m256i space = _mm256_set1_epi8(32);
+    size_t i = 0;
+
+    for (; (i + 32) <= length; i += 32)
     {
-        return NULL;
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(const void*)(input + i));
+        unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(chunk, space), space));
+        if (mask != 0)
+        {
+            return i + trailing_zeros(mask);
+        }
     }
-    if (object->valuestring != NULL)
+
+    return i + sse2_find_non_whitespace(input + i, length - i);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2_find_escape(const unsigned char *input, size_t length)
+{
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(31);
+    size_t i = 0;
+
+    for (; (i + 32) <= length; i += 32)
     {
-        cJSON_free(object->valuestring);
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(const void*)(input + i));
+        __m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(special, _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control), control)));
+        if (mask != 0)
+        {
+            return i + trailing_zeros(mask);
+        }
     }
-    object->valuestring = copy;
 
-    return copy;
+    return i + sse2_find_escape(input + i, length - i);
 }
 
-typedef struct
-{
-    unsigned char *buffer;
-    size_t length;
-    size_t offset;
-    size_t depth; /* current nesting depth (for formatted printing) */
-    cJSON_bool noalloc;
-    cJSON_bool format; /* is this print a formatted print */
-    internal_hooks hooks;
-} printbuffer;
+#define simd_has_avx2() __builtin_cpu_supports("avx2")
+#endif /* CJSON_SIMD_AVX2 */
 
-/* realloc printbuffer if necessary to have at least "needed" bytes more */
-static unsigned char* ensure(printbuffer * const p, size_t needed)
+#ifdef CJSON_SIMD_NEON
+static size_t neon_find_string_special(const unsigned char *input, size_t length)
 {
-    unsigned char *newbuffer = NULL;
-    size_t newsize = 0;
+    const uint8x16_t quote = vdupq_n_u8('\"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    size_t i = 0;
 
-    if ((p == NULL) || (p->buffer == NULL))
+    for (; (i + 16) <= length; i += 16)
     {
-        return NULL;
+        uint8x16_t chunk = vld1q_u8(input + i);
+        if (vmaxvq_u8(vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash))) != 0)
+        {
+            break;
+        }
     }
 
-    if ((p->length > 0) && (p->offset >= p->length))
-    {
-        /* make sure that offset is valid */
-        return NULL;
-    }
+    return i + scalar_find_string_special(input + i, length - i);
+}
 
-    if (needed > INT_MAX)
+static size_t neon_find_non_whitespace(const unsigned char *input, size_t length)
+{
+    const uint8x16_t space = vdupq_n_u8(32);
+    size_t i = 0;
+
+    for (; (i + 16) <= length; i += 16)
     {
-        /* sizes bigger than INT_MAX are currently not supported */
-        return NULL;
+        if (vmaxvq_u8(vcgtq_u8(vld1q_u8(input + i), space)) != 0)
+        {
+            break;
+        }
     }
 
-    needed += p->offset + 1;
-    if (needed <= p->length)
-    {
-        return p->buffer + p->offset;
-    }
+    return i + scalar_find_non_whitespace(input + i, length - i);
+}
 
-    if (p->noalloc) {
-        return NULL;
-    }
+static size_t neon_find_escape(const unsigned char *input, size_t length)
+{
+    const uint8x16_t quote = vdupq_n_u8('\"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t space = vdupq_n_u8(32);
+    size_t i = 0;
 
-    /* calculate new buffer size */
-    if (needed > (INT_MAX / 2))
+    for (; (i + 16) <= length; i += 16)
     {
-        /* overflow of int, use INT_MAX if possible */
-        if (needed <= INT_MAX)
-        {
-            newsize = INT_MAX;
-        }
-        else
+        uint8x16_t chunk = vld1q_u8(input + i);
+        uint8x16_t special = vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash));
+        if (vmaxvq_u8(vorrq_u8(special, vcltq_u8(chunk, space))) != 0)
         {
-            return NULL;
+            break;
         }
     }
-    else
+
+    return i + scalar_find_escape(input + i, length - i);
+}
+#endif /* CJSON_SIMD_NEON */
+
+/* index of the first '\"' or '\\' in input (length if there is none) */
+static size_t find_string_special(const unsigned char *input, size_t length)
+{
+#if defined(CJSON_SIMD_AVX2)
+    if ((length >= 32) && simd_has_avx2())
     {
-        newsize = needed * 2;
+        return avx2_find_string_special(input, length);
     }
+#endif
+#if defined(CJSON_SIMD_SSE2)
+    return sse2_find_string_special(input, length);
+#elif defined(CJSON_SIMD_NEON)
+    return neon_find_string_special(input, length);
+#else
+    return scalar_find_string_special(input, length);
+#endif
+}
 
-    if (p->hooks.reallocate != NULL)
+/* index of the first byte > 32 in input (length if there is none) */
+static size_t find_non_whitespace(const unsigned char *input, size_t length)
+{
+    /* usually there is none or only little whitespace */
+    if ((length == 0) || (input[0] > 32))
     {
-        /* reallocate with realloc if available */
-        newbuffer = (unsigned char*)p->hooks.reallocate(p->buffer, newsize);
-        if (newbuffer == NULL)
-        {
-            p->hooks.deallocate(p->buffer);
-            p->length = 0;
-            p->buffer = NULL;
-
-            return NULL;
-        }
+        return 0;
     }
-    else
+#if defined(CJSON_SIMD_AVX2)
+    if ((length >= 32) && simd_has_avx2())
     {
-        /* otherwise reallocate manually */
-        newbuffer = (unsigned char*)p->hooks.allocate(newsize);
-        if (!newbuffer)
-        {
-            p->hooks.deallocate(p->buffer);
-            p->length = 0;
-            p->buffer = NULL;
-
-            return NULL;
-        }
-        if (newbuffer)
-        {
-            memcpy(newbuffer, p->buffer, p->offset + 1);
-        }
-        p->hooks.deallocate(p->buffer);
+        return avx2_find_non_whitespace(input, length);
     }
-    p->length = newsize;
-    p->buffer = newbuffer;
-
-    return newbuffer + p->offset;
+#endif
+#if defined(CJSON_SIMD_SSE2)
+    return sse2_find_non_whitespace(input, length);
+#elif defined(CJSON_SIMD_NEON)
+    return neon_find_non_whitespace(input, length);
+#else
+    return scalar_find_non_whitespace(input, length);
+#endif
 }
 
-/* calculate the new length of the string in a printbuffer and update the offset */
-static void update_offset(printbuffer * const buffer)
+/* index of the first byte in input that has to be escaped when printing (length if there is none) */
+static size_t find_escape(const unsigned char *input, size_t length)
 {
-    const unsigned char *buffer_pointer = NULL;
-    if ((buffer == NULL) || (buffer->buffer == NULL))
+#if defined(CJSON_SIMD_AVX2)
+    if ((length >= 32) && simd_has_avx2())
     {
-        return;
+        return avx2_find_escape(input, length);
     }
-    buffer_pointer = buffer->buffer + buffer->offset;
-
-    buffer->offset += strlen((const char*)buffer_pointer);
+#endif
+#if defined(CJSON_SIMD_SSE2)
+    return sse2_find_escape(input, length);
+#elif defined(CJSON_SIMD_NEON)
+    return neon_find_escape(input, length);
+#else
+    return scalar_find_escape(input, length);
+#endif
 }
 
-/* securely comparison of floating-point variables */
-static cJSON_bool compare_double(double a, double b)
+/* is c a character of a number as copied for strtod() by parse_number() */
+static cJSON_bool is_number_character(const unsigned char c)
 {
-    double maxVal = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
-    return (fabs(a - b) <= maxVal * DBL_EPSILON);
+    return ((c >= '0') && (c <= '9')) || (c == '+') || (c == '-') || (c == 'e') || (c == 'E') || (c == '.');
 }
 
-/* Render the number nicely from the given item into a string. */
-static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
+/* maximal length of a number handled by parse_number() */
+#define NUMBER_MAX_LENGTH 63
+
+/* parse an integer literal exactly, returns the number of characters consumed or 0 if the number
+ * isn't an integer literal that fits into 64 bits */
+static size_t parse_integer(const unsigned char * const input, const size_t length, int64_t * const integer, int * const flags)
 {
-    unsigned char *output_pointer = NULL;
-    double d = item->valuedouble;
-    int length = 0;
+    uint64_t magnitude = 0;
+    cJSON_bool negative = false;
     size_t i = 0;
-    unsigned char number_buffer[26] = {0}; /* temporary buffer to print the number into */
-    unsigned char decimal_point = get_decimal_point();
-    double test = 0.0;
 
-    if (output_buffer == NULL)
+    if ((i < length) && (input[i] == '-'))
     {
-        return false;
+        negative = true;
+        i++;
     }
-
-    /* This checks for NaN and Infinity */
-    if (isnan(d) || isinf(d))
+    if ((i >= length) || (input[i] < '0') || (input[i] > '9'))
     {
-        length = sprintf((char*)number_buffer, "null");
+        return 0;
     }
-    else
-    {
-        /* Try 15 decimal places of precision to avoid nonsignificant nonzero digits */
-        length = sprintf((char*)number_buffer, "%1.15g", d);
 
-        /* Check whether the original double can be recovered */
-        if ((sscanf((char*)number_buffer, "%lg", &test) != 1) || !compare_double((double)test, d))
+    for (; (i < length) && (input[i] >= '0') && (input[i] <= '9'); i++)
+    {
+        const unsigned int digit = (unsigned int)(input[i] - '0');
+        if (magnitude > ((UINT64_MAX - digit) / 10))
         {
-            /* If not, print with 17 decimal places of precision */
-            length = sprintf((char*)number_buffer, "%1.17g", d);
+            return 0;
         }
+        magnitude = (magnitude * 10) + digit;
     }
 
-    /* sprintf failed or buffer overrun occurred */
-    if ((length < 0) || (length > (int)(sizeof(number_buffer) - 1)))
+    /* fractions, exponents, leading zeros and -0 are left to the other paths */
+    if (((i < length) && is_number_character(input[i])) || (i > NUMBER_MAX_LENGTH) || ((input[negative ? 1 : 0] == '0') && (i > (negative ? 2u : 1u))) || (negative && (magnitude == 0)))
     {
-        return false;
-    }
-
-    /* reserve appropriate space in the output */
-    output_pointer = ensure(output_buffer, (size_t)length + sizeof(""));
-    if (output_pointer == NULL)
-    {
-        return false;
+        return 0;
     }
 
-    /* copy the printed number to the output and replace locale
-     * dependent decimal point with '.' */
-    for (i = 0; i < ((size_t)length); i++)
+    if (negative)
     {
-        if (number_buffer[i] == decimal_point)
+        if (magnitude > ((uint64_t)INT64_MAX + 1))
         {
-            output_pointer[i] = '.';
-            continue;
+            return 0;
         }
-
-        output_pointer[i] = number_buffer[i];
+        *integer = (magnitude == ((uint64_t)INT64_MAX + 1)) ? INT64_MIN : -(int64_t)magnitude;
+        *flags = cJSON_NumberIsInt;
+    }
+    else if (magnitude > (uint64_t)INT64_MAX)
+    {
+        /* two's complement representation without relying on implementation defined conversions */
+        *integer = (int64_t)(magnitude - ((uint64_t)INT64_MAX + 1)) + INT64_MIN;
+        *flags = cJSON_NumberIsInt | cJSON_NumberIsUint;
+    }
+    else
+    {
+        *integer = (int64_t)magnitude;
+        *flags = cJSON_NumberIsInt;
     }
-    output_pointer[i] = '\0';
-
-    output_buffer->offset += (size_t)length;
 
-    return true;
+    return i;
 }
 
-/* parse 4 digit hexadecimal number */
-static unsigned parse_hex4(const unsigned char * const input)
+/* Clinger's fast path, only used when double arithmetic is not done in a higher precision */
+#if defined(FLT_EVAL_METHOD) && (FLT_EVAL_METHOD == 0) && !defined(CJSON_NO_FAST_NUMBERS)
+#define CJSON_FAST_NUMBERS
+#endif
+
+#ifdef CJSON_FAST_NUMBERS
+/* numbers with up to 15 significant digits (< 2^53) are exactly representable as double */
+#define FAST_NUMBER_MAX_DIGITS 15
+
+/* parse a number without strtod() if the result is guaranteed to be exact, returns the number of
+ * characters consumed or 0 if the number has to be parsed by strtod() */
+static size_t parse_number_fast(const unsigned char * const input, const size_t length, double * const number)
 {
-    unsigned int h = 0;
+    /* powers of ten that are exactly representable as double */
+    static const double powers_of_ten[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    double mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    int explicit_exponent = 0;
+    cJSON_bool negative = false;
+    cJSON_bool negative_exponent = false;
     size_t i = 0;
 
-    for (i = 0; i < 4; i++)
+    if ((i < length) && (input[i] == '-'))
     {
-        /* parse digit */
-        if ((input[i] >= '0') && (input[i] <= '9'))
+        negative = true;
+        i++;
+    }
+    if ((i >= length) || (input[i] < '0') || (input[i] > '9'))
+    {
+        return 0;
+    }
+
+    /* integer part, a leading zero is left as is and handled by the final check */
+    if (input[i] == '0')
+    {
+        i++;
+    }
+    else
+    {
+        for (; (i < length) && (input[i] >= '0') && (input[i] <= '9'); i++)
         {
-            h += (unsigned int) input[i] - '0';
+            if (digits == FAST_NUMBER_MAX_DIGITS)
+            {
+                return 0;
+            }
+            mantissa = (mantissa * 10) + (input[i] - '0');
+            digits++;
         }
-        else if ((input[i] >= 'A') && (input[i] <= 'F'))
+    }
+
+    /* fraction */
+    if ((i < length) && (input[i] == '.'))
+    {
+        i++;
+        if ((i >= length) || (input[i] < '0') || (input[i] > '9'))
         {
-            h += (unsigned int) 10 + input[i] - 'A';
+            return 0;
         }
-        else if ((input[i] >= 'a') && (input[i] <= 'f'))
+        for (; (i < length) && (input[i] >= '0') && (input[i] <= '9'); i++)
         {
-            h += (unsigned int) 10 + input[i] - 'a';
+            exponent--;
+            if ((digits == 0) && (input[i] == '0'))
+            {
+                /* leading zeros are not significant */
+                continue;
+            }
+            if (digits == FAST_NUMBER_MAX_DIGITS)
+            {
+                return 0;
+            }
+            mantissa = (mantissa * 10) + (input[i] - '0');
+            digits++;
         }
-        else /* invalid */
+    }
+
+    /* exponent */
+    if ((i < length) && ((input[i] == 'e') || (input[i] == 'E')))
+    {
+        i++;
+        if ((i < length) && ((input[i] == '+') || (input[i] == '-')))
+        {
+            negative_exponent = (input[i] == '-');
+            i++;
+        }
+        if ((i >= length) || (input[i] < '0') || (input[i] > '9'))
         {
             return 0;
         }
-
-        if (i < 3)
+        for (; (i < length) && (input[i] >= '0') && (input[i] <= '9'); i++)
         {
-            /* shift left to make place for the next nibble */
-            h = h << 4;
+            if (explicit_exponent < 10000)
+            {
+                explicit_exponent = (explicit_exponent * 10) + (input[i] - '0');
+            }
         }
+        exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
     }
 
-    return h;
-}
-
-/* converts a UTF-16 literal to UTF-8
- * A literal can be one or two sequences of the form \uXXXX */
-static unsigned char utf16_literal_to_utf8(const unsigned char * const input_pointer, const unsigned char * const input_end, unsigned char **output_pointer)
-{
-    long unsigned int codepoint = 0;
-    unsigned int first_code = 0;
-    const unsigned char *first_sequence = input_pointer;
-    unsigned char utf8_length = 0;
-    unsigned char utf8_position = 0;
-    unsigned char sequence_length = 0;
-    unsigned char first_byte_mark = 0;
-
-    if ((input_end - first_sequence) < 6)
+    /* leave everything strtod() would parse differently to it (e.g. "01", "1.e5", long numbers) */
+    if (((i < length) && is_number_character(input[i])) || (i > NUMBER_MAX_LENGTH))
     {
-        /* input ends unexpectedly */
-        goto fail;
+        return 0;
     }
 
-    /* get the first utf16 sequence */
-    first_code = parse_hex4(first_sequence + 2);
-
-    /* check that the code is valid */
-    if (((first_code >= 0xDC00) && (first_code <= 0xDFFF)))
+    if (digits == 0)
     {
-        goto fail;
+        mantissa = 0;
     }
-
-    /* UTF16 surrogate pair */
-    if ((first_code >= 0xD800) && (first_code <= 0xDBFF))
+    else if (exponent < 0)
     {
-        const unsigned char *second_sequence = first_sequence + 6;
-        unsigned int second_code = 0;
-        sequence_length = 12; /* \uXXXX\uXXXX */
-
-        if ((input_end - second_sequence) < 6)
+        if (exponent < -22)
         {
-            /* input ends unexpectedly */
-            goto fail;
+            return 0;
         }
-
-        if ((second_sequence[0] != '\\') || (second_sequence[1] != 'u'))
+        mantissa /= powers_of_ten[-exponent];
+    }
+    else if (exponent > 0)
+    {
+        if (exponent > 22)
         {
-            /* missing second half of the surrogate pair */
-            goto fail;
+            /* e.g. 1e30 = 1e8 * 1e22, as long as the first product stays exact */
+            if ((digits + exponent - 22) > FAST_NUMBER_MAX_DIGITS)
+            {
+                return 0;
+            }
+            mantissa *= powers_of_ten[exponent - 22];
+            exponent = 22;
         }
+        mantissa *= powers_of_ten[exponent];
+    }
 
-        /* get the second utf16 sequence */
-        second_code = parse_hex4(second_sequence + 2);
-        /* check that the code is valid */
-        if ((second_code < 0xDC00) || (second_code > 0xDFFF))
-        {
-            /* invalid second half of the surrogate pair */
-            goto fail;
-        }
+    *number = negative ? -mantissa : mantissa;
 
+    return i;
+}
+#endif /* CJSON_FAST_NUMBERS */
 
-        /* calculate the unicode codepoint from the surrogate pair */
-        codepoint = 0x10000 + (((first_code & 0x3FF) << 10) | (second_code & 0x3FF));
-    }
-    else
+/* Parse the input text to generate a number, and populate the result into item. */
+static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
+{
+    double number = 0;
+    unsigned char *after_end = NULL;
+    unsigned char number_c_string[NUMBER_MAX_LENGTH + 1];
+    unsigned char decimal_point = 0;
+    size_t length = 0;
+    size_t i = 0;
+    int64_t integer = 0;
+    int flags = 0;
+
+    if ((input_buffer == NULL) || (input_buffer->content == NULL))
     {
-        sequence_length = 6; /* \uXXXX */
-        codepoint = first_code;
+        return false;
     }
 
-    /* encode as UTF-8
-     * takes at maximum 4 bytes to encode:
-     * 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
-    if (codepoint < 0x80)
+    length = parse_integer(buffer_at_offset(input_buffer), input_buffer->length - input_buffer->offset, &integer, &flags);
+    if (length != 0)
     {
-        /* normal ascii, encoding 0xxxxxxx */
-        utf8_length = 1;
+        /* correctly rounded like strtod() */
+        number = (flags & cJSON_NumberIsUint) ? (double)(uint64_t)integer : (double)integer;
+        goto number_end;
     }
-    else if (codepoint < 0x800)
+
+#ifdef CJSON_FAST_NUMBERS
+    length = parse_number_fast(buffer_at_offset(input_buffer), input_buffer->length - input_buffer->offset, &number);
+    if (length != 0)
     {
-        /* two bytes, encoding 110xxxxx 10xxxxxx */
-        utf8_length = 2;
-        first_byte_mark = 0xC0; /* 11000000 */
+        goto number_end;
     }
-    else if (codepoint < 0x10000)
+#endif
+
+    /* copy the number into a temporary buffer and replace '.' with the decimal point
+     * of the current locale (for strtod)
+     * This also takes care of '\0' not necessarily being available for marking the end of the input */
+    decimal_point = get_decimal_point();
+    for (i = 0; (i < (sizeof(number_c_string) - 1)) && can_access_at_index(input_buffer, i); i++)
+    {
+        const unsigned char c = buffer_at_offset(input_buffer)[i];
+        if (!is_number_character(c))
+        {
+            break;
+        }
+        number_c_string[i] = (c == '.') ? decimal_point : c;
+    }
+    number_c_string[i] = '\0';
+
+    number = strtod((const char*)number_c_string, (char**)&after_end);
+    if (number_c_string == after_end)
+    {
+        return false; /* parse_error */
+    }
+    length = (size_t)(after_end - number_c_string);
+
+number_end:
+    item->valuedouble = number;
+    item->valueint64 = integer;
+
+    /* use saturation in case of overflow */
+    if (number >= INT_MAX)
+    {
+        item->valueint = INT_MAX;
+    }
+    else if (number <= (double)INT_MIN)
+    {
+        item->valueint = INT_MIN;
+    }
+    else
+    {
+        item->valueint = (int)number;
+    }
+
+    item->type = cJSON_Number | flags;
+
+    input_buffer->offset += length;
+    return true;
+}
+
+/* don't ask me, but the original cJSON_SetNumberValue returns an integer or double */
+CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number)
+{
+    if (number >= INT_MAX)
+    {
+        object->valueint = INT_MAX;
+    }
+    else if (number <= (double)INT_MIN)
+    {
+        object->valueint = INT_MIN;
+    }
+    else
+    {
+        object->valueint = (int)number;
+    }
+    object->type &= ~(cJSON_NumberIsInt | cJSON_NumberIsUint);
+
+    return object->valuedouble = number;
+}
+
+CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring)
+{
+    char *copy = NULL;
+    /* if object's type is not cJSON_String or is cJSON_IsReference, it should not set valuestring */
+    if (!(object->type & cJSON_String) || (object->type & cJSON_IsReference))
+    {
+        return NULL;
+    }
+    if (strlen(valuestring) <= strlen(object->valuestring))
+    {
+        strcpy(object->valuestring, valuestring);
+        return object->valuestring;
+    }
+    copy = (char*) cJSON_strdup((const unsigned char*)valuestring, current_hooks());
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+    if (object->valuestring != NULL)
+    {
+        cJSON_free(object->valuestring);
+    }
+    object->valuestring = copy;
+
+    return copy;
+}
+
+typedef struct
+{
+    unsigned char *buffer;
+    size_t length;
+    size_t offset;
+    size_t depth; /* current nesting depth (for formatted printing) */
+    cJSON_bool noalloc;
+    cJSON_bool format; /* is this print a formatted print */
+    internal_hooks hooks;
+} printbuffer;
+
+/* realloc printbuffer if necessary to have at least "needed" bytes more */
+static unsigned char* ensure(printbuffer * const p, size_t needed)
+{
+    unsigned char *newbuffer = NULL;
+    size_t newsize = 0;
+
+    if ((p == NULL) || (p->buffer == NULL))
+    {
+        return NULL;
+    }
+
+    if ((p->length > 0) && (p->offset >= p->length))
+    {
+        /* make sure that offset is valid */
+        return NULL;
+    }
+
+    if (needed > INT_MAX)
+    {
+        /* sizes bigger than INT_MAX are currently not supported */
+        return NULL;
+    }
+
+    needed += p->offset + 1;
+    if (needed <= p->length)
+    {
+        return p->buffer + p->offset;
+    }
+
+    if (p->noalloc) {
+        return NULL;
+    }
+
+    /* calculate new buffer size */
+    if (needed > (INT_MAX / 2))
+    {
+        /* overflow of int, use INT_MAX if possible */
+        if (needed <= INT_MAX)
+        {
+            newsize = INT_MAX;
+        }
+        else
+        {
+            return NULL;
+        }
+    }
+    else
+    {
+        newsize = needed * 2;
+    }
+
+    if (p->hooks.reallocate != NULL)
+    {
+        /* reallocate with realloc if available */
+        newbuffer = (unsigned char*)p->hooks.reallocate(p->buffer, newsize);
+        if (newbuffer == NULL)
+        {
+            p->hooks.deallocate(p->buffer);
+            p->length = 0;
+            p->buffer = NULL;
+
+            return NULL;
+        }
+    }
+    else
+    {
+        /* otherwise reallocate manually */
+        newbuffer = (unsigned char*)p->hooks.allocate(newsize);
+        if (!newbuffer)
+        {
+            p->hooks.deallocate(p->buffer);
+            p->length = 0;
+            p->buffer = NULL;
+
+            return NULL;
+        }
+        if (newbuffer)
+        {
+            memcpy(newbuffer, p->buffer, p->offset + 1);
+        }
+        p->hooks.deallocate(p->buffer);
+    }
+    p->length = newsize;
+    p->buffer = newbuffer;
+
+    return newbuffer + p->offset;
+}
+
+/* calculate the new length of the string in a printbuffer and update the offset */
+static void update_offset(printbuffer * const buffer)
+{
+    const unsigned char *buffer_pointer = NULL;
+    if ((buffer == NULL) || (buffer->buffer == NULL))
+    {
+        return;
+    }
+    buffer_pointer = buffer->buffer + buffer->offset;
+
+    buffer->offset += strlen((const char*)buffer_pointer);
+}
+
+/* securely comparison of floating-point variables */
+static cJSON_bool compare_double(double a, double b)
+{
+    double maxVal = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
+    return (fabs(a - b) <= maxVal * DBL_EPSILON);
+}
+
+/* shortest roundtrip number printing (Grisu2 by Florian Loitsch, "Printing Floating-Point Numbers
+ * Quickly and Accurately with Integers", PLDI 2010), the digits always read back as the same double */
+
+/* do-it-yourself floating point number f * 2^e */
+typedef struct
+{
+    uint64_t f;
+    int e;
+} diy_fp;
+
+typedef struct
+{
+    uint64_t f;
+    int e;
+    int k; /* decimal exponent */
+} cached_power;
+
+/* normalized 10^k for k = -300, -292, ..., 324 */
+static const cached_power cached_powers[] = {
+        { 0xAB70FE17C79AC6CAULL, -1060, -300 },
+        { 0xFF77B1FCBEBCDC4FULL, -1034, -292 },
+        { 0xBE5691EF416BD60CULL, -1007, -284 },
+        { 0x8DD01FAD907FFC3CULL, -980, -276 },
+        { 0xD3515C2831559A83ULL, -954, -268 },
+        { 0x9D71AC8FADA6C9B5ULL, -927, -260 },
+        { 0xEA9C227723EE8BCBULL, -901, -252 },
+        { 0xAECC49914078536DULL, -874, -244 },
+        { 0x823C12795DB6CE57ULL, -847, -236 },
+        { 0xC21094364DFB5637ULL, -821, -228 },
+        { 0x9096EA6F3848984FULL, -794, -220 },
+        { 0xD77485CB25823AC7ULL, -768, -212 },
+        { 0xA086CFCD97BF97F4ULL, -741, -204 },
+        { 0xEF340A98172AACE5ULL, -715, -196 },
+        { 0xB23867FB2A35B28EULL, -688, -188 },
+        { 0x84C8D4DFD2C63F3BULL, -661, -180 },
+        { 0xC5DD44271AD3CDBAULL, -635, -172 },
+        { 0x936B9FCEBB25C996ULL, -608, -164 },
+        { 0xDBAC6C247D62A584ULL, -582, -156 },
+        { 0xA3AB66580D5FDAF6ULL, -555, -148 },
+        { 0xF3E2F893DEC3F126ULL, -529, -140 },
+        { 0xB5B5ADA8AAFF80B8ULL, -502, -132 },
+        { 0x87625F056C7C4A8BULL, -475, -124 },
+        { 0xC9BCFF6034C13053ULL, -449, -116 },
+        { 0x964E858C91BA2655ULL, -422, -108 },
+        { 0xDFF9772470297EBDULL, -396, -100 },
+        { 0xA6DFBD9FB8E5B88FULL, -369, -92 },
+        { 0xF8A95FCF88747D94ULL, -343, -84 },
+        { 0xB94470938FA89BCFULL, -316, -76 },
+        { 0x8A08F0F8BF0F156BULL, -289, -68 },
+        { 0xCDB02555653131B6ULL, -263, -60 },
+        { 0x993FE2C6D07B7FACULL, -236, -52 },
+        { 0xE45C10C42A2B3B06ULL, -210, -44 },
+        { 0xAA242499697392D3ULL, -183, -36 },
+        { 0xFD87B5F28300CA0EULL, -157, -28 },
+        { 0xBCE5086492111AEBULL, -130, -20 },
+        { 0x8CBCCC096F5088CCULL, -103, -12 },
+        { 0xD1B71758E219652CULL, -77, -4 },
+        { 0x9C40000000000000ULL, -50, 4 },
+        { 0xE8D4A51000000000ULL, -24, 12 },
+        { 0xAD78EBC5AC620000ULL, 3, 20 },
+        { 0x813F3978F8940984ULL, 30, 28 },
+        { 0xC097CE7BC90715B3ULL, 56, 36 },
+        { 0x8F7E32CE7BEA5C70ULL, 83, 44 },
+        { 0xD5D238A4ABE98068ULL, 109, 52 },
+        { 0x9F4F2726179A2245ULL, 136, 60 },
+        { 0xED63A231D4C4FB27ULL, 162, 68 },
+        { 0xB0DE65388CC8ADA8ULL, 189, 76 },
+        { 0x83C7088E1AAB65DBULL, 216, 84 },
+        { 0xC45D1DF942711D9AULL, 242, 92 },
+        { 0x924D692CA61BE758ULL, 269, 100 },
+        { 0xDA01EE641A708DEAULL, 295, 108 },
+        { 0xA26DA3999AEF774AULL, 322, 116 },
+        { 0xF209787BB47D6B85ULL, 348, 124 },
+        { 0xB454E4A179DD1877ULL, 375, 132 },
+        { 0x865B86925B9BC5C2ULL, 402, 140 },
+        { 0xC83553C5C8965D3DULL, 428, 148 },
+        { 0x952AB45CFA97A0B3ULL, 455, 156 },
+        { 0xDE469FBD99A05FE3ULL, 481, 164 },
+        { 0xA59BC234DB398C25ULL, 508, 172 },
+        { 0xF6C69A72A3989F5CULL, 534, 180 },
+        { 0xB7DCBF5354E9BECEULL, 561, 188 },
+        { 0x88FCF317F22241E2ULL, 588, 196 },
+        { 0xCC20CE9BD35C78A5ULL, 614, 204 },
+        { 0x98165AF37B2153DFULL, 641, 212 },
+        { 0xE2A0B5DC971F303AULL, 667, 220 },
+        { 0xA8D9D1535CE3B396ULL, 694, 228 },
+        { 0xFB9B7CD9A4A7443CULL, 720, 236 },
+        { 0xBB764C4CA7A44410ULL, 747, 244 },
+        { 0x8BAB8EEFB6409C1AULL, 774, 252 },
+        { 0xD01FEF10A657842CULL, 800, 260 },
+        { 0x9B10A4E5E9913129ULL, 827, 268 },
+        { 0xE7109BFBA19C0C9DULL, 853, 276 },
+        { 0xAC2820D9623BF429ULL, 880, 284 },
+        { 0x80444B5E7AA7CF85ULL, 907, 292 },
+        { 0xBF21E44003ACDD2DULL, 933, 300 },
+        { 0x8E679C2F5E44FF8FULL, 960, 308 },
+        { 0xD433179D9C8CB841ULL, 986, 316 },
+        { 0x9E19DB92B4E31BA9ULL, 1013, 324 }
+};
+
+#define CACHED_POWERS_MIN_DECIMAL_EXPONENT (-300)
+#define CACHED_POWERS_DECIMAL_STEP 8
+/* range of the binary exponent of the scaled numbers */
+#define GRISU_ALPHA (-60)
+
+static diy_fp diy_fp_sub(const diy_fp x, const diy_fp y)
+{
+    diy_fp result;
+    result.f = x.f - y.f;
+    result.e = x.e;
+    return result;
+}
+
+/* upper 64 bits of the 128 bit product, rounded */
+static diy_fp diy_fp_mul(const diy_fp x, const diy_fp y)
+{
+    const uint64_t x_lo = x.f & 0xFFFFFFFFu;
+    const uint64_t x_hi = x.f >> 32;
+    const uint64_t y_lo = y.f & 0xFFFFFFFFu;
+    const uint64_t y_hi = y.f >> 32;
+    const uint64_t p0 = x_lo * y_lo;
+    const uint64_t p1 = x_lo * y_hi;
+    const uint64_t p2 = x_hi * y_lo;
+    const uint64_t p3 = x_hi * y_hi;
+    uint64_t q = (p0 >> 32) + (p1 & 0xFFFFFFFFu) + (p2 & 0xFFFFFFFFu);
+    diy_fp result;
+
+    q += (uint64_t)1 << 31; /* round */
+    result.f = p3 + (p1 >> 32) + (p2 >> 32) + (q >> 32);
+    result.e = x.e + y.e + 64;
+    return result;
+}
+
+static diy_fp diy_fp_normalize(diy_fp x)
+{
+    while ((x.f >> 63) == 0)
+    {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+/* smallest power of ten scaling a number with binary exponent e into [GRISU_ALPHA, GRISU_ALPHA + 28] */
+static cached_power get_cached_power(const int e)
+{
+    const int f = GRISU_ALPHA - e - 1;
+    /* ceil(f * log10(2)) */
+    const int k = (f * 78913) / (1 << 18) + (f > 0);
+    const int index = (-CACHED_POWERS_MIN_DECIMAL_EXPONENT + k + (CACHED_POWERS_DECIMAL_STEP - 1)) / CACHED_POWERS_DECIMAL_STEP;
+
+    return cached_powers[index];
+}
+
+static void grisu2_round(unsigned char * const buffer, const int length, const uint64_t distance, const uint64_t delta, uint64_t rest, const uint64_t ten_k)
+{
+    /* move the last digit towards the exact value as long as it stays inside the rounding interval */
+    while ((rest < distance) && ((delta - rest) >= ten_k) && (((rest + ten_k) < distance) || ((distance - rest) > (rest + ten_k - distance))))
+    {
+        buffer[length - 1]--;
+        rest += ten_k;
+    }
+}
+
+/* generate the shortest digits of a number in [m_minus, m_plus] closest to w, returns the number of digits */
+static int grisu2_digit_gen(unsigned char * const buffer, int * const decimal_exponent, const diy_fp m_minus, const diy_fp w, const diy_fp m_plus)
+{
+    static const uint32_t powers_of_ten[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+    uint64_t delta = diy_fp_sub(m_plus, m_minus).f;
+    uint64_t distance = diy_fp_sub(m_plus, w).f;
+    const int one_e = -m_plus.e;
+    const uint64_t one_f = (uint64_t)1 << one_e;
+    uint32_t p1 = (uint32_t)(m_plus.f >> one_e);
+    uint64_t p2 = m_plus.f & (one_f - 1);
+    int length = 0;
+    int n = 10;
+    int m = 0;
+
+    /* integral part */
+    while ((n > 1) && (p1 < powers_of_ten[n - 1]))
+    {
+        n--;
+    }
+    while (n > 0)
+    {
+        const uint32_t pow10 = powers_of_ten[n - 1];
+        uint64_t rest;
+
+        buffer[length++] = (unsigned char)('0' + (p1 / pow10));
+        p1 %= pow10;
+        n--;
+
+        rest = ((uint64_t)p1 << one_e) + p2;
+        if (rest <= delta)
+        {
+            *decimal_exponent += n;
+            grisu2_round(buffer, length, distance, delta, rest, (uint64_t)pow10 << one_e);
+            return length;
+        }
+    }
+
+    /* fractional part */
+    for (;;)
+    {
+        p2 *= 10;
+        buffer[length++] = (unsigned char)('0' + (p2 >> one_e));
+        p2 &= one_f - 1;
+        m++;
+
+        delta *= 10;
+        distance *= 10;
+        if (p2 <= delta)
+        {
+            break;
+        }
+    }
+    *decimal_exponent -= m;
+    grisu2_round(buffer, length, distance, delta, p2, one_f);
+
+    return length;
+}
+
+/* shortest digits of the finite, positive double value, returns the number of digits */
+static int grisu2(unsigned char * const buffer, int * const decimal_exponent, const double value)
+{
+    const uint64_t hidden_bit = (uint64_t)1 << 52;
+    uint64_t bits = 0;
+    uint64_t fraction = 0;
+    int biased_exponent = 0;
+    cJSON_bool lower_boundary_is_closer = false;
+    diy_fp v;
+    diy_fp m_plus;
+    diy_fp m_minus;
+    diy_fp c_minus_k;
+    cached_power cached;
+
+    memcpy(&bits, &value, sizeof(bits));
+    fraction = bits & (hidden_bit - 1);
+    biased_exponent = (int)(bits >> 52);
+
+    if (biased_exponent == 0)
+    {
+        /* subnormal */
+        v.f = fraction;
+        v.e = 1 - 1075;
+    }
+    else
+    {
+        v.f = fraction + hidden_bit;
+        v.e = biased_exponent - 1075;
+    }
+    lower_boundary_is_closer = (fraction == 0) && (biased_exponent > 1);
+
+    /* boundaries of the rounding interval of v */
+    m_plus.f = (v.f << 1) + 1;
+    m_plus.e = v.e - 1;
+    m_plus = diy_fp_normalize(m_plus);
+    if (lower_boundary_is_closer)
+    {
+        m_minus.f = (v.f << 2) - 1;
+        m_minus.e = v.e - 2;
+    }
+    else
+    {
+        m_minus.f = (v.f << 1) - 1;
+        m_minus.e = v.e - 1;
+    }
+    m_minus.f <<= m_minus.e - m_plus.e;
+    m_minus.e = m_plus.e;
+    v = diy_fp_normalize(v);
+
+    /* scale into the range where the digits can be generated with 64 bit integers */
+    cached = get_cached_power(m_plus.e);
+    c_minus_k.f = cached.f;
+    c_minus_k.e = cached.e;
+    v = diy_fp_mul(v, c_minus_k);
+    m_minus = diy_fp_mul(m_minus, c_minus_k);
+    m_plus = diy_fp_mul(m_plus, c_minus_k);
+
+    /* stay strictly inside the interval, the products are only approximations */
+    m_minus.f++;
+    m_plus.f--;
+
+    *decimal_exponent = -cached.k;
+    return grisu2_digit_gen(buffer, decimal_exponent, m_minus, v, m_plus);
+}
+
+/* write an integer to buffer, returns the number of digits */
+static int print_integer_digits(unsigned char * const buffer, uint64_t integer)
+{
+    unsigned char reversed[20];
+    int length = 0;
+    int i = 0;
+
+    do
+    {
+        reversed[length++] = (unsigned char)('0' + (integer % 10));
+        integer /= 10;
+    } while (integer != 0);
+
+    for (i = 0; i < length; i++)
+    {
+        buffer[i] = reversed[length - 1 - i];
+    }
+
+    return length;
+}
+
+/* lay out digits * 10^decimal_exponent like printf's %g with 15 (or 17 for longer digit strings)
+ * significant digits would, returns the length */
+static int format_number(unsigned char * const output, const unsigned char * const digits, int length, int decimal_exponent)
+{
+    unsigned char *pointer = output;
+    int exponent = 0;
+    int precision = 0;
+    int i = 0;
+
+    /* %g doesn't print trailing zeros */
+    while ((length > 1) && (digits[length - 1] == '0'))
+    {
+        length--;
+        decimal_exponent++;
+    }
+
+    exponent = length + decimal_exponent - 1;
+    precision = (length <= 15) ? 15 : 17;
+    if ((exponent < -4) || (exponent >= precision))
+    {
+        /* d.ddde+XX */
+        *pointer++ = digits[0];
+        if (length > 1)
+        {
+            *pointer++ = '.';
+            memcpy(pointer, digits + 1, (size_t)(length - 1));
+            pointer += length - 1;
+        }
+        *pointer++ = 'e';
+        *pointer++ = (exponent < 0) ? '-' : '+';
+        exponent = (exponent < 0) ? -exponent : exponent;
+        if (exponent >= 100)
+        {
+            *pointer++ = (unsigned char)('0' + (exponent / 100));
+            exponent %= 100;
+        }
+        *pointer++ = (unsigned char)('0' + (exponent / 10));
+        *pointer++ = (unsigned char)('0' + (exponent % 10));
+    }
+    else if (decimal_exponent >= 0)
+    {
+        /* ddd000 */
+        memcpy(pointer, digits, (size_t)length);
+        pointer += length;
+        for (i = 0; i < decimal_exponent; i++)
+        {
+            *pointer++ = '0';
+        }
+    }
+    else if (exponent >= 0)
+    {
+        /* dd.ddd */
+        memcpy(pointer, digits, (size_t)(exponent + 1));
+        pointer += exponent + 1;
+        *pointer++ = '.';
+        memcpy(pointer, digits + exponent + 1, (size_t)(length - exponent - 1));
+        pointer += length - exponent - 1;
+    }
+    else
+    {
+        /* 0.000ddd */
+        *pointer++ = '0';
+        *pointer++ = '.';
+        for (i = -1; i > exponent; i--)
+        {
+            *pointer++ = '0';
+        }
+        memcpy(pointer, digits, (size_t)length);
+        pointer += length;
+    }
+
+    return (int)(pointer - output);
+}
+
+/* Render the number nicely from the given item into a string. */
+static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
+{
+    unsigned char *output_pointer = NULL;
+    double d = item->valuedouble;
+    int length = 0;
+    unsigned char number_buffer[26] = {0}; /* temporary buffer to print the number into */
+    unsigned char digits[20];
+    int digits_length = 0;
+    int decimal_exponent = 0;
+
+    if (output_buffer == NULL)
+    {
+        return false;
+    }
+
+    /* This checks for NaN and Infinity */
+    if (isnan(d) || isinf(d))
+    {
+        memcpy(number_buffer, "null", sizeof("null"));
+        length = sizeof("null") - 1;
+    }
+    else if (number_has_int64(item))
+    {
+        /* exact integers, e.g. ids and counters beyond 2^53 */
+        uint64_t magnitude = (uint64_t)item->valueint64;
+        if (!(item->type & cJSON_NumberIsUint) && (item->valueint64 < 0))
+        {
+            number_buffer[length++] = '-';
+            magnitude = 0 - magnitude;
+        }
+        length += print_integer_digits(number_buffer + length, magnitude);
+    }
+    else
+    {
+        if (signbit(d))
+        {
+            number_buffer[length++] = '-';
+            d = -d;
+        }
+
+        if ((d < 1e15) && (floor(d) == d))
+        {
+            /* whole numbers are printed exactly */
+            digits_length = print_integer_digits(digits, (uint64_t)d);
+        }
+        else
+        {
+            digits_length = grisu2(digits, &decimal_exponent, d);
+        }
+        length += format_number(number_buffer + length, digits, digits_length, decimal_exponent);
+    }
+
+    /* reserve appropriate space in the output */
+    output_pointer = ensure(output_buffer, (size_t)length + sizeof(""));
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+
+    memcpy(output_pointer, number_buffer, (size_t)length);
+    output_pointer[length] = '\0';
+
+    output_buffer->offset += (size_t)length;
+
+    return true;
+}
+
+/* parse 4 digit hexadecimal number */
+static unsigned parse_hex4(const unsigned char * const input)
+{
+    unsigned int h = 0;
+    size_t i = 0;
+
+    for (i = 0; i < 4; i++)
+    {
+        /* parse digit */
+        if ((input[i] >= '0') && (input[i] <= '9'))
+        {
+            h += (unsigned int) input[i] - '0';
+        }
+        else if ((input[i] >= 'A') && (input[i] <= 'F'))
+        {
+            h += (unsigned int) 10 + input[i] - 'A';
+        }
+        else if ((input[i] >= 'a') && (input[i] <= 'f'))
+        {
+            h += (unsigned int) 10 + input[i] - 'a';
+        }
+        else /* invalid */
+        {
+            return 0;
+        }
+
+        if (i < 3)
+        {
+            /* shift left to make place for the next nibble */
+            h = h << 4;
+        }
+    }
+
+    return h;
+}
+
+/* converts a UTF-16 literal to UTF-8
+ * A literal can be one or two sequences of the form \uXXXX */
+static unsigned char utf16_literal_to_utf8(const unsigned char * const input_pointer, const unsigned char * const input_end, unsigned char **output_pointer)
+{
+    long unsigned int codepoint = 0;
+    unsigned int first_code = 0;
+    const unsigned char *first_sequence = input_pointer;
+    unsigned char utf8_length = 0;
+    unsigned char utf8_position = 0;
+    unsigned char sequence_length = 0;
+    unsigned char first_byte_mark = 0;
+
+    if ((input_end - first_sequence) < 6)
+    {
+        /* input ends unexpectedly */
+        goto fail;
+    }
+
+    /* get the first utf16 sequence */
+    first_code = parse_hex4(first_sequence + 2);
+
+    /* check that the code is valid */
+    if (((first_code >= 0xDC00) && (first_code <= 0xDFFF)))
+    {
+        goto fail;
+    }
+
+    /* UTF16 surrogate pair */
+    if ((first_code >= 0xD800) && (first_code <= 0xDBFF))
+    {
+        const unsigned char *second_sequence = first_sequence + 6;
+        unsigned int second_code = 0;
+        sequence_length = 12; /* \uXXXX\uXXXX */
+
+        if ((input_end - second_sequence) < 6)
+        {
+            /* input ends unexpectedly */
+            goto fail;
+        }
+
+        if ((second_sequence[0] != '\\') || (second_sequence[1] != 'u'))
+        {
+            /* missing second half of the surrogate pair */
+            goto fail;
+        }
+
+        /* get the second utf16 sequence */
+        second_code = parse_hex4(second_sequence + 2);
+        /* check that the code is valid */
+        if ((second_code < 0xDC00) || (second_code > 0xDFFF))
+        {
+            /* invalid second half of the surrogate pair */
+            goto fail;
+        }
+
+
+        /* calculate the unicode codepoint from the surrogate pair */
+        codepoint = 0x10000 + (((first_code & 0x3FF) << 10) | (second_code & 0x3FF));
+    }
+    else
+    {
+        sequence_length = 6; /* \uXXXX */
+        codepoint = first_code;
+    }
+
+    /* encode as UTF-8
+     * takes at maximum 4 bytes to encode:
+     * 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
+    if (codepoint < 0x80)
+    {
+        /* normal ascii, encoding 0xxxxxxx */
+        utf8_length = 1;
+    }
+    else if (codepoint < 0x800)
+    {
+        /* two bytes, encoding 110xxxxx 10xxxxxx */
+        utf8_length = 2;
+        first_byte_mark = 0xC0; /* 11000000 */
+    }
+    else if (codepoint < 0x10000)
     {
         /* three bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx */
         utf8_length = 3;
         first_byte_mark = 0xE0; /* 11100000 */
     }
-    else if (codepoint <= 0x10FFFF)
+    else if (codepoint <= 0x10FFFF)
+    {
+        /* four bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx 10xxxxxx */
+        utf8_length = 4;
+        first_byte_mark = 0xF0; /* 11110000 */
+    }
+    else
+    {
+        /* invalid unicode codepoint */
+        goto fail;
+    }
+
+    /* encode as utf8 */
+    for (utf8_position = (unsigned char)(utf8_length - 1); utf8_position > 0; utf8_position--)
+    {
+        /* 10xxxxxx */
+        (*output_pointer)[utf8_position] = (unsigned char)((codepoint | 0x80) & 0xBF);
+        codepoint >>= 6;
+    }
+    /* encode first byte */
+    if (utf8_length > 1)
+    {
+        (*output_pointer)[0] = (unsigned char)((codepoint | first_byte_mark) & 0xFF);
+    }
+    else
+    {
+        (*output_pointer)[0] = (unsigned char)(codepoint & 0x7F);
+    }
+
+    *output_pointer += utf8_length;
+
+    return sequence_length;
+
+fail:
+    return 0;
+}
+
+/* Find the closing quote of the string literal at the buffer offset, output_length is at least the size of its unescaped value. */
+static cJSON_bool scan_string(parse_buffer * const input_buffer, const unsigned char **input_end, size_t * const output_length)
+{
+    const unsigned char *buffer_end = input_buffer->content + input_buffer->length;
+    const unsigned char *end = NULL;
+    size_t skipped_bytes = 0;
+
+    /* not a string */
+    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '\"'))
+    {
+        return false;
+    }
+
+    end = buffer_at_offset(input_buffer) + 1;
+    while (end < buffer_end)
+    {
+        end += find_string_special(end, (size_t)(buffer_end - end));
+        if ((end >= buffer_end) || (*end == '\"'))
+        {
+            break;
+        }
+        /* is escape sequence */
+        if ((end + 1) >= buffer_end)
+        {
+            /* prevent buffer overflow when last input character is a backslash */
+            return false;
+        }
+        skipped_bytes++;
+        end += 2;
+    }
+    if (((size_t)(end - input_buffer->content) >= input_buffer->length) || (*end != '\"'))
+    {
+        return false; /* string ended unexpectedly */
+    }
+
+    *input_end = end;
+    /* This is at most how much we need for the output */
+    *output_length = (size_t) (end - buffer_at_offset(input_buffer)) - skipped_bytes;
+    if ((*output_length - 1) > thread_limits.max_string)
+    {
+        input_buffer->limit = true;
+        return false;
+    }
+
+    return true;
+}
+
+/* Unescape the string literal up to input_end into output (which may alias the input) and zero terminate it.
+ * Returns the end of the output, or NULL with input_pointer at the invalid escape sequence. */
+static unsigned char *unescape_string(const unsigned char **input_pointer, const unsigned char * const input_end, unsigned char *output_pointer)
+{
+    const unsigned char *input = *input_pointer;
+
+    /* loop through the string literal */
+    while (input < input_end)
+    {
+        if (*input != '\\')
+        {
+            /* copy everything up to the next escape sequence at once */
+            const unsigned char *escape = (const unsigned char*)memchr(input, '\\', (size_t)(input_end - input));
+            size_t run_length = (size_t)(((escape != NULL) ? escape : input_end) - input);
+            if (output_pointer != input)
+            {
+                /* in situ the output trails the input once an escape sequence was decoded */
+                memmove(output_pointer, input, run_length);
+            }
+            output_pointer += run_length;
+            input += run_length;
+        }
+        /* escape sequence */
+        else
+        {
+            unsigned char sequence_length = 2;
+            if ((input_end - input) < 1)
+            {
+                goto fail;
+            }
+
+            switch (input[1])
+            {
+                case 'b':
+                    *output_pointer++ = '\b';
+                    break;
+                case 'f':
+                    *output_pointer++ = '\f';
+                    break;
+                case 'n':
+                    *output_pointer++ = '\n';
+                    break;
+                case 'r':
+                    *output_pointer++ = '\r';
+                    break;
+                case 't':
+                    *output_pointer++ = '\t';
+                    break;
+                case '\"':
+                case '\\':
+                case '/':
+                    *output_pointer++ = input[1];
+                    break;
+
+                /* UTF-16 literal */
+                case 'u':
+                    sequence_length = utf16_literal_to_utf8(input, input_end, &output_pointer);
+                    if (sequence_length == 0)
+                    {
+                        /* failed to convert UTF16-literal to UTF-8 */
+                        goto fail;
+                    }
+                    break;
+
+                default:
+                    goto fail;
+            }
+            input += sequence_length;
+        }
+    }
+
+    /* zero terminate the output */
+    *output_pointer = '\0';
+    *input_pointer = input;
+
+    return output_pointer;
+
+fail:
+    *input_pointer = input;
+
+    return NULL;
+}
+
+/* Parse the input text into an unescaped cinput, and populate item. */
+static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_buffer)
+{
+    const unsigned char *input_pointer = buffer_at_offset(input_buffer) + 1;
+    const unsigned char *input_end = NULL;
+    unsigned char *output = NULL;
+    size_t allocation_length = 0;
+
+    if (!scan_string(input_buffer, &input_end, &allocation_length))
+    {
+        goto fail;
+    }
+
+    if (input_buffer->in_situ != NULL)
+    {
+        /* decode into the input itself, the output is never longer than the escaped
+         * input and its terminator takes the place of the closing quote */
+        output = input_buffer->in_situ + (input_pointer - input_buffer->content);
+    }
+    else
+    {
+        output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
+        if (output == NULL)
+        {
+            goto fail; /* allocation failure */
+        }
+    }
+
+    if (unescape_string(&input_pointer, input_end, output) == NULL)
+    {
+        goto fail;
+    }
+
+    item->type = cJSON_String;
+    if (input_buffer->in_situ != NULL)
+    {
+        /* the string is owned by the input buffer */
+        item->type |= cJSON_IsReference;
+    }
+    item->valuestring = (char*)output;
+
+    input_buffer->offset = (size_t) (input_end - input_buffer->content);
+    input_buffer->offset++;
+
+    return true;
+
+fail:
+    if ((output != NULL) && (input_buffer->in_situ == NULL))
+    {
+        input_buffer->hooks.deallocate(output);
+    }
+
+    if (input_pointer != NULL)
+    {
+        input_buffer->offset = (size_t)(input_pointer - input_buffer->content);
+    }
+
+    return false;
+}
+
+/* Render the cstring provided to an escaped version that can be printed. */
+static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffer * const output_buffer)
+{
+    const unsigned char *input_pointer = NULL;
+    const unsigned char *input_end = NULL;
+    size_t input_length = 0;
+    unsigned char *output = NULL;
+    unsigned char *output_pointer = NULL;
+    size_t output_length = 0;
+    /* numbers of additional characters needed for escaping */
+    size_t escape_characters = 0;
+
+    if (output_buffer == NULL)
+    {
+        return false;
+    }
+
+    /* empty string */
+    if (input == NULL)
+    {
+        output = ensure(output_buffer, sizeof("\"\""));
+        if (output == NULL)
+        {
+            return false;
+        }
+        strcpy((char*)output, "\"\"");
+
+        return true;
+    }
+
+    input_length = strlen((const char*)input);
+    input_end = input + input_length;
+
+    /* count the additional characters needed for escaping, only the characters to escape are visited */
+    for (input_pointer = input + find_escape(input, input_length); input_pointer < input_end; input_pointer += 1 + find_escape(input_pointer + 1, (size_t)(input_end - input_pointer - 1)))
+    {
+        switch (*input_pointer)
+        {
+            case '\"':
+            case '\\':
+            case '\b':
+            case '\f':
+            case '\n':
+            case '\r':
+            case '\t':
+                /* one character escape sequence */
+                escape_characters++;
+                break;
+            default:
+                /* UTF-16 escape sequence uXXXX */
+                escape_characters += 5;
+                break;
+        }
+    }
+    output_length = input_length + escape_characters;
+
+    output = ensure(output_buffer, output_length + sizeof("\"\""));
+    if (output == NULL)
+    {
+        return false;
+    }
+
+    /* no characters have to be escaped */
+    if (escape_characters == 0)
+    {
+        output[0] = '\"';
+        memcpy(output + 1, input, output_length);
+        output[output_length + 1] = '\"';
+        output[output_length + 2] = '\0';
+
+        return true;
+    }
+
+    output[0] = '\"';
+    output_pointer = output + 1;
+    /* copy the string */
+    input_pointer = input;
+    while (input_pointer < input_end)
+    {
+        /* normal characters, copy everything up to the next character to escape at once */
+        size_t run_length = find_escape(input_pointer, (size_t)(input_end - input_pointer));
+        memcpy(output_pointer, input_pointer, run_length);
+        output_pointer += run_length;
+        input_pointer += run_length;
+        if (input_pointer == input_end)
+        {
+            break;
+        }
+
+        /* character needs to be escaped */
+        *output_pointer++ = '\\';
+        switch (*input_pointer)
+        {
+            case '\\':
+                *output_pointer = '\\';
+                break;
+            case '\"':
+                *output_pointer = '\"';
+                break;
+            case '\b':
+                *output_pointer = 'b';
+                break;
+            case '\f':
+                *output_pointer = 'f';
+                break;
+            case '\n':
+                *output_pointer = 'n';
+                break;
+            case '\r':
+                *output_pointer = 'r';
+                break;
+            case '\t':
+                *output_pointer = 't';
+                break;
+            default:
+                /* escape and print as unicode codepoint, same as sprintf("u%04x") */
+                output_pointer[0] = 'u';
+                output_pointer[1] = '0';
+                output_pointer[2] = '0';
+                output_pointer[3] = (unsigned char)('0' + (*input_pointer >> 4));
+                output_pointer[4] = (unsigned char)"0123456789abcdef"[*input_pointer & 0x0F];
+                output_pointer += 4;
+                break;
+        }
+        output_pointer++;
+        input_pointer++;
+    }
+    output[output_length + 1] = '\"';
+    output[output_length + 2] = '\0';
+
+    return true;
+}
+
+/* Invoke print_string_ptr (which is useful) on an item. */
+static cJSON_bool print_string(const cJSON * const item, printbuffer * const p)
+{
+    return print_string_ptr((unsigned char*)item->valuestring, p);
+}
+
+/* Predeclare these prototypes. */
+static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer);
+static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer);
+static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer);
+
+/* Utility to jump whitespace and cr/lf */
+static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
+{
+    if ((buffer == NULL) || (buffer->content == NULL))
+    {
+        return NULL;
+    }
+
+    if (cannot_access_at_index(buffer, 0))
+    {
+        return buffer;
+    }
+
+    buffer->offset += find_non_whitespace(buffer_at_offset(buffer), buffer->length - buffer->offset);
+
+    if (buffer->offset == buffer->length)
+    {
+        buffer->offset--;
+    }
+
+    return buffer;
+}
+
+/* skip the UTF-8 BOM (byte order mark) if it is at the beginning of a buffer */
+static parse_buffer *skip_utf8_bom(parse_buffer * const buffer)
+{
+    if ((buffer == NULL) || (buffer->content == NULL) || (buffer->offset != 0))
+    {
+        return NULL;
+    }
+
+    if (can_access_at_index(buffer, 4) && (strncmp((const char*)buffer_at_offset(buffer), "\xEF\xBB\xBF", 3) == 0))
+    {
+        buffer->offset += 3;
+    }
+
+    return buffer;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    size_t buffer_length;
+
+    if (NULL == value)
+    {
+        return NULL;
+    }
+
+    /* Adding null character size due to require_null_terminated. */
+    buffer_length = strlen(value) + sizeof("");
+
+    return cJSON_ParseWithLengthOpts(value, buffer_length, return_parse_end, require_null_terminated);
+}
+
+/* Remember the position of a parse error in buffer for cJSON_GetErrorPtr and return_parse_end. */
+static void set_parse_error(const char *value, const parse_buffer * const buffer, const char **return_parse_end)
+{
+    if (value != NULL)
+    {
+        error local_error;
+        local_error.json = (const unsigned char*)value;
+        local_error.position = 0;
+        local_error.limit = buffer->limit;
+
+        if (buffer->offset < buffer->length)
+        {
+            local_error.position = buffer->offset;
+        }
+        else if (buffer->length > 0)
+        {
+            local_error.position = buffer->length - 1;
+        }
+
+        if (return_parse_end != NULL)
+        {
+            *return_parse_end = (const char*)local_error.json + local_error.position;
+        }
+
+        global_error = local_error;
+    }
+}
+
+/* Parse an object - create a new root, and populate. */
+static cJSON *parse_with_length_opts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated, unsigned char *in_situ)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 }, 0, 0 };
+    cJSON *item = NULL;
+
+    /* reset error position */
+    global_error.json = NULL;
+    global_error.position = 0;
+    global_error.limit = false;
+
+    if (value == NULL || 0 == buffer_length)
+    {
+        goto fail;
+    }
+
+    buffer.content = (const unsigned char*)value;
+    buffer.length = buffer_length; 
+    buffer.offset = 0;
+    buffer.hooks = *current_hooks();
+    buffer.in_situ = in_situ;
+    if (buffer_length > thread_limits.max_length)
+    {
+        buffer.limit = true;
+        goto fail;
+    }
+
+    item = cJSON_New_Item(current_hooks());
+    if (item == NULL) /* memory fail */
+    {
+        goto fail;
+    }
+
+    if (!parse_value(item, buffer_skip_whitespace(skip_utf8_bom(&buffer))))
+    {
+        /* parse failure. ep is set. */
+        goto fail;
+    }
+
+    /* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
+    if (require_null_terminated)
+    {
+        buffer_skip_whitespace(&buffer);
+        if ((buffer.offset >= buffer.length) || buffer_at_offset(&buffer)[0] != '\0')
+        {
+            goto fail;
+        }
+    }
+    if (return_parse_end)
+    {
+        *return_parse_end = (const char*)buffer_at_offset(&buffer);
+    }
+
+    return item;
+
+fail:
+    if (item != NULL)
+    {
+        cJSON_Delete(item);
+    }
+
+    set_parse_error(value, &buffer, return_parse_end);
+
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    return parse_with_length_opts(value, buffer_length, return_parse_end, require_null_terminated, NULL);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    return parse_with_length_opts(value, buffer_length, return_parse_end, require_null_terminated, (unsigned char*)value);
+}
+
+/* Default options for cJSON_Parse */
+CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
+{
+    return cJSON_ParseWithOpts(value, 0, 0);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_length)
+{
+    return cJSON_ParseWithLengthOpts(value, buffer_length, 0, 0);
+}
+
+typedef struct
+{
+    uint64_t *entries;
+    size_t length;
+    size_t capacity;
+    unsigned char *strings;
+    size_t strings_length;
+    size_t strings_capacity;
+    internal_hooks hooks;
+} tape_builder;
+
+#define tape_entry(type, payload) ((((uint64_t)(type)) << 56) | (uint64_t)(payload))
+
+/* Grow buffer (of capacity elements) to hold at least needed elements, returns NULL and leaves buffer alone on failure. */
+static void *tape_grow(void *buffer, size_t * const capacity, const size_t needed, const size_t element_size, const internal_hooks * const hooks)
+{
+    size_t new_capacity = (*capacity > 0) ? *capacity : 64;
+    void *new_buffer = NULL;
+
+    while (new_capacity < needed)
+    {
+        if (new_capacity > ((SIZE_MAX / element_size) / 2))
+        {
+            return NULL;
+        }
+        new_capacity *= 2;
+    }
+
+    if (hooks->reallocate != NULL)
+    {
+        new_buffer = hooks->reallocate(buffer, new_capacity * element_size);
+    }
+    else
+    {
+        new_buffer = hooks->allocate(new_capacity * element_size);
+        if ((new_buffer != NULL) && (buffer != NULL))
+        {
+            memcpy(new_buffer, buffer, *capacity * element_size);
+            hooks->deallocate(buffer);
+        }
+    }
+    if (new_buffer != NULL)
+    {
+        *capacity = new_capacity;
+    }
+
+    return new_buffer;
+}
+
+static cJSON_bool tape_push(tape_builder * const tape, const uint64_t entry)
+{
+    if (tape->length == tape->capacity)
+    {
+        uint64_t *entries = (uint64_t*)tape_grow(tape->entries, &tape->capacity, tape->length + 1, sizeof(uint64_t), &tape->hooks);
+        if (entries == NULL)
+        {
+            return false;
+        }
+        tape->entries = entries;
+    }
+    tape->entries[tape->length++] = entry;
+
+    return true;
+}
+
+/* Unescape a string into the string buffer of the tape, prefixed by its length. */
+static cJSON_bool parse_tape_string(tape_builder * const tape, parse_buffer * const input_buffer)
+{
+    const unsigned char *input_pointer = buffer_at_offset(input_buffer) + 1;
+    const unsigned char *input_end = NULL;
+    unsigned char *output = NULL;
+    unsigned char *output_end = NULL;
+    size_t output_length = 0;
+    uint32_t length = 0;
+
+    if (!scan_string(input_buffer, &input_end, &output_length))
+    {
+        goto fail;
+    }
+
+    output_length += sizeof(length) + sizeof("");
+    if ((tape->strings_capacity - tape->strings_length) < output_length)
+    {
+        unsigned char *strings = (unsigned char*)tape_grow(tape->strings, &tape->strings_capacity, tape->strings_length + output_length, 1, &tape->hooks);
+        if (strings == NULL)
+        {
+            goto fail; /* allocation failure */
+        }
+        tape->strings = strings;
+    }
+
+    output = tape->strings + tape->strings_length + sizeof(length);
+    output_end = unescape_string(&input_pointer, input_end, output);
+    if ((output_end == NULL) || ((size_t)(output_end - output) > UINT32_MAX))
+    {
+        goto fail;
+    }
+    length = (uint32_t)(output_end - output);
+    memcpy(tape->strings + tape->strings_length, &length, sizeof(length));
+
+    if (!tape_push(tape, tape_entry('"', tape->strings_length)))
+    {
+        goto fail;
+    }
+    tape->strings_length += sizeof(length) + length + sizeof("");
+
+    input_buffer->offset = (size_t) (input_end - input_buffer->content);
+    input_buffer->offset++;
+
+    return true;
+
+fail:
+    input_buffer->offset = (size_t)(input_pointer - input_buffer->content);
+
+    return false;
+}
+
+static cJSON_bool parse_tape_value(tape_builder * const tape, parse_buffer * const input_buffer);
+
+/* Same grammar as parse_array and parse_object, the start entry is filled in once the end is known. */
+static cJSON_bool parse_tape_container(tape_builder * const tape, parse_buffer * const input_buffer)
+{
+    const unsigned char open = buffer_at_offset(input_buffer)[0];
+    const unsigned char close = (open == '{') ? '}' : ']';
+    const size_t start = tape->length;
+    size_t count = 0;
+
+    if (input_buffer->depth >= thread_limits.max_depth)
+    {
+        input_buffer->limit = true;
+        return false; /* to deeply nested */
+    }
+    input_buffer->depth++;
+
+    if (!tape_push(tape, 0))
+    {
+        return false;
+    }
+
+    input_buffer->offset++;
+    buffer_skip_whitespace(input_buffer);
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == close))
+    {
+        goto success; /* empty array or object */
+    }
+
+    /* check if we skipped to the end of the buffer */
+    if (cannot_access_at_index(input_buffer, 0))
+    {
+        input_buffer->offset--;
+        return false;
+    }
+
+    /* step back to character in front of the first element */
+    input_buffer->offset--;
+    /* loop through the comma separated elements */
+    do
+    {
+        if (count >= ((open == '{') ? thread_limits.max_members : thread_limits.max_elements))
+        {
+            input_buffer->limit = true;
+            return false;
+        }
+        input_buffer->offset++;
+        buffer_skip_whitespace(input_buffer);
+        if (open == '{')
+        {
+            /* parse the name of the member */
+            if (!parse_tape_string(tape, input_buffer))
+            {
+                return false;
+            }
+            buffer_skip_whitespace(input_buffer);
+            if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
+            {
+                return false; /* invalid object */
+            }
+            input_buffer->offset++;
+            buffer_skip_whitespace(input_buffer);
+        }
+
+        if (!parse_tape_value(tape, input_buffer))
+        {
+            return false;
+        }
+        count++;
+        buffer_skip_whitespace(input_buffer);
+    }
+    while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
+
+    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != close))
+    {
+        return false; /* expected end of array or object */
+    }
+
+success:
+    input_buffer->depth--;
+
+    if (!tape_push(tape, tape_entry(close, start)) || (tape->length > UINT32_MAX))
+    {
+        return false;
+    }
+    if (count > cJSON_TapeCountMax)
+    {
+        count = cJSON_TapeCountMax;
+    }
+    tape->entries[start] = tape_entry(open, ((uint64_t)count << 32) | tape->length);
+
+    input_buffer->offset++;
+    return true;
+}
+
+/* Same grammar as parse_value. */
+static cJSON_bool parse_tape_value(tape_builder * const tape, parse_buffer * const input_buffer)
+{
+    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+    {
+        return false; /* no input */
+    }
+
+    /* parse the different types of values */
+    /* null */
+    if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "null", 4) == 0))
+    {
+        input_buffer->offset += 4;
+        return tape_push(tape, tape_entry('n', 0));
+    }
+    /* false */
+    if (can_read(input_buffer, 5) && (strncmp((const char*)buffer_at_offset(input_buffer), "false", 5) == 0))
+    {
+        input_buffer->offset += 5;
+        return tape_push(tape, tape_entry('f', 0));
+    }
+    /* true */
+    if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "true", 4) == 0))
+    {
+        input_buffer->offset += 4;
+        return tape_push(tape, tape_entry('t', 0));
+    }
+    if (cannot_access_at_index(input_buffer, 0))
+    {
+        return false;
+    }
+    /* string */
+    if (buffer_at_offset(input_buffer)[0] == '\"')
+    {
+        return parse_tape_string(tape, input_buffer);
+    }
+    /* number */
+    if ((buffer_at_offset(input_buffer)[0] == '-') || ((buffer_at_offset(input_buffer)[0] >= '0') && (buffer_at_offset(input_buffer)[0] <= '9')))
+    {
+        cJSON number;
+        uint64_t bits = 0;
+        unsigned char type = 'd';
+
+        memset(&number, '\0', sizeof(number));
+        if (!parse_number(&number, input_buffer))
+        {
+            return false;
+        }
+        if (number.type & cJSON_NumberIsInt)
+        {
+            type = (number.type & cJSON_NumberIsUint) ? 'u' : 'l';
+            bits = (uint64_t)number.valueint64;
+        }
+        else
+        {
+            memcpy(&bits, &number.valuedouble, sizeof(bits));
+        }
+        return tape_push(tape, tape_entry(type, 0)) && tape_push(tape, bits);
+    }
+    /* array or object */
+    if ((buffer_at_offset(input_buffer)[0] == '[') || (buffer_at_offset(input_buffer)[0] == '{'))
     {
-        /* four bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx 10xxxxxx */
-        utf8_length = 4;
-        first_byte_mark = 0xF0; /* 11110000 */
+        return parse_tape_container(tape, input_buffer);
     }
-    else
+
+    return false;
+}
+
+CJSON_PUBLIC(cJSON_Tape *) cJSON_ParseTape(const char *value, size_t buffer_length, const char **return_parse_end)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 }, 0, 0 };
+    tape_builder builder;
+    cJSON_Tape *tape = NULL;
+
+    memset(&builder, '\0', sizeof(builder));
+
+    /* reset error position */
+    global_error.json = NULL;
+    global_error.position = 0;
+    global_error.limit = false;
+
+    if (value == NULL || 0 == buffer_length)
     {
-        /* invalid unicode codepoint */
         goto fail;
     }
 
-    /* encode as utf8 */
-    for (utf8_position = (unsigned char)(utf8_length - 1); utf8_position > 0; utf8_position--)
+    buffer.content = (const unsigned char*)value;
+    buffer.length = buffer_length;
+    buffer.offset = 0;
+    buffer.hooks = *current_hooks();
+    builder.hooks = buffer.hooks;
+    if (buffer_length > thread_limits.max_length)
     {
-        /* 10xxxxxx */
-        (*output_pointer)[utf8_position] = (unsigned char)((codepoint | 0x80) & 0xBF);
-        codepoint >>= 6;
+        buffer.limit = true;
+        goto fail;
     }
-    /* encode first byte */
-    if (utf8_length > 1)
+
+    tape = (cJSON_Tape*)buffer.hooks.allocate(sizeof(cJSON_Tape));
+    if (tape == NULL) /* memory fail */
     {
-        (*output_pointer)[0] = (unsigned char)((codepoint | first_byte_mark) & 0xFF);
+        goto fail;
     }
-    else
+
+    /* size both buffers for typical input up front, so that they rarely have to grow */
+    builder.entries = (uint64_t*)tape_grow(NULL, &builder.capacity, (buffer_length / 4) + 16, sizeof(uint64_t), &builder.hooks);
+    builder.strings = (unsigned char*)tape_grow(NULL, &builder.strings_capacity, buffer_length + 64, 1, &builder.hooks);
+    if ((builder.entries == NULL) || (builder.strings == NULL))
     {
-        (*output_pointer)[0] = (unsigned char)(codepoint & 0x7F);
+        goto fail;
     }
 
-    *output_pointer += utf8_length;
+    if (!parse_tape_value(&builder, buffer_skip_whitespace(skip_utf8_bom(&buffer))))
+    {
+        /* parse failure. ep is set. */
+        goto fail;
+    }
 
-    return sequence_length;
+    if (return_parse_end)
+    {
+        *return_parse_end = (const char*)buffer_at_offset(&buffer);
+    }
+
+    tape->entries = builder.entries;
+    tape->length = builder.length;
+    tape->strings = builder.strings;
+    tape->strings_length = builder.strings_length;
+
+    return tape;
 
 fail:
-    return 0;
+    if (builder.entries != NULL)
+    {
+        builder.hooks.deallocate(builder.entries);
+    }
+    if (builder.strings != NULL)
+    {
+        builder.hooks.deallocate(builder.strings);
+    }
+    if (tape != NULL)
+    {
+        builder.hooks.deallocate(tape);
+    }
+
+    set_parse_error(value, &buffer, return_parse_end);
+
+    return NULL;
 }
 
-/* Parse the input text into an unescaped cinput, and populate item. */
-static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_buffer)
+CJSON_PUBLIC(void) cJSON_DeleteTape(cJSON_Tape *tape)
 {
-    const unsigned char *input_pointer = buffer_at_offset(input_buffer) + 1;
-    const unsigned char *input_end = buffer_at_offset(input_buffer) + 1;
-    unsigned char *output_pointer = NULL;
-    unsigned char *output = NULL;
-
-    /* not a string */
-    if (buffer_at_offset(input_buffer)[0] != '\"')
+    if (tape == NULL)
     {
-        goto fail;
+        return;
     }
 
+    if (tape->entries != NULL)
     {
-        /* calculate approximate size of the output (overestimate) */
-        size_t allocation_length = 0;
-        size_t skipped_bytes = 0;
-        while (((size_t)(input_end - input_buffer->content) < input_buffer->length) && (*input_end != '\"'))
-        {
-            /* is escape sequence */
-            if (input_end[0] == '\\')
-            {
-                if ((size_t)(input_end + 1 - input_buffer->content) >= input_buffer->length)
-                {
-                    /* prevent buffer overflow when last input character is a backslash */
-                    goto fail;
-                }
-                skipped_bytes++;
-                input_end++;
-            }
-            input_end++;
-        }
-        if (((size_t)(input_end - input_buffer->content) >= input_buffer->length) || (*input_end != '\"'))
-        {
-            goto fail; /* string ended unexpectedly */
-        }
-
-        /* This is at most how much we need for the output */
-        allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
-        output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
-        if (output == NULL)
-        {
-            goto fail; /* allocation failure */
-        }
+        current_hooks()->deallocate(tape->entries);
     }
-
-    output_pointer = output;
-    /* loop through the string literal */
-    while (input_pointer < input_end)
+    if (tape->strings != NULL)
     {
-        if (*input_pointer != '\\')
-        {
-            *output_pointer++ = *input_pointer++;
-        }
-        /* escape sequence */
-        else
-        {
-            unsigned char sequence_length = 2;
-            if ((input_end - input_pointer) < 1)
-            {
-                goto fail;
-            }
-
-            switch (input_pointer[1])
-            {
-                case 'b':
-                    *output_pointer++ = '\b';
-                    break;
-                case 'f':
-                    *output_pointer++ = '\f';
-                    break;
-                case 'n':
-                    *output_pointer++ = '\n';
-                    break;
-                case 'r':
-                    *output_pointer++ = '\r';
-                    break;
-                case 't':
-                    *output_pointer++ = '\t';
-                    break;
-                case '\"':
-                case '\\':
-                case '/':
-                    *output_pointer++ = input_pointer[1];
-                    break;
-
-                /* UTF-16 literal */
-                case 'u':
-                    sequence_length = utf16_literal_to_utf8(input_pointer, input_end, &output_pointer);
-                    if (sequence_length == 0)
-                    {
-                        /* failed to convert UTF16-literal to UTF-8 */
-                        goto fail;
-                    }
-                    break;
+        current_hooks()->deallocate(tape->strings);
+    }
+    current_hooks()->deallocate(tape);
+}
 
-                default:
-                    goto fail;
-            }
-            input_pointer += sequence_length;
-        }
+CJSON_PUBLIC(size_t) cJSON_TapeSkip(const cJSON_Tape *tape, size_t index)
+{
+    if ((tape == NULL) || (index >= tape->length))
+    {
+        return index;
     }
 
-    /* zero terminate the output */
-    *output_pointer = '\0';
+    switch (cJSON_TapeType(tape->entries[index]))
+    {
+        case '{':
+        case '[':
+            return (size_t)(tape->entries[index] & 0xFFFFFFFF);
 
-    item->type = cJSON_String;
-    item->valuestring = (char*)output;
+        case 'l':
+        case 'u':
+        case 'd':
+            return index + 2;
 
-    input_buffer->offset = (size_t) (input_end - input_buffer->content);
-    input_buffer->offset++;
+        default:
+            return index + 1;
+    }
+}
 
-    return true;
+CJSON_PUBLIC(const char *) cJSON_TapeGetString(const cJSON_Tape *tape, size_t index, size_t *length)
+{
+    const unsigned char *string = NULL;
+    uint32_t string_length = 0;
 
-fail:
-    if (output != NULL)
+    if ((tape == NULL) || (index >= tape->length) || (cJSON_TapeType(tape->entries[index]) != '"'))
     {
-        input_buffer->hooks.deallocate(output);
+        return NULL;
     }
 
-    if (input_pointer != NULL)
+    string = tape->strings + cJSON_TapePayload(tape->entries[index]);
+    if (length != NULL)
     {
-        input_buffer->offset = (size_t)(input_pointer - input_buffer->content);
+        memcpy(&string_length, string, sizeof(string_length));
+        *length = string_length;
     }
 
-    return false;
+    return (const char*)string + sizeof(string_length);
 }
 
-/* Render the cstring provided to an escaped version that can be printed. */
-static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffer * const output_buffer)
+CJSON_PUBLIC(cJSON_bool) cJSON_TapeGetValue(const cJSON_Tape *tape, size_t index, cJSON *item)
 {
-    const unsigned char *input_pointer = NULL;
-    unsigned char *output = NULL;
-    unsigned char *output_pointer = NULL;
-    size_t output_length = 0;
-    /* numbers of additional characters needed for escaping */
-    size_t escape_characters = 0;
+    double number = 0;
+    int64_t integer = 0;
+    int flags = 0;
 
-    if (output_buffer == NULL)
+    if ((tape == NULL) || (index >= tape->length) || (item == NULL))
     {
         return false;
     }
 
-    /* empty string */
-    if (input == NULL)
+    memset(item, '\0', sizeof(cJSON));
+    switch (cJSON_TapeType(tape->entries[index]))
     {
-        output = ensure(output_buffer, sizeof("\"\""));
-        if (output == NULL)
-        {
-            return false;
-        }
-        strcpy((char*)output, "\"\"");
+        case 'n':
+            item->type = cJSON_NULL;
+            return true;
 
-        return true;
+        case 'f':
+            item->type = cJSON_False;
+            return true;
+
+        case 't':
+            item->type = cJSON_True;
+            item->valueint = 1;
+            return true;
+
+        case '"':
+            /* the string belongs to the tape */
+            item->type = cJSON_String | cJSON_IsReference;
+            item->valuestring = (char*)tape->strings + cJSON_TapePayload(tape->entries[index]) + sizeof(uint32_t);
+            return true;
+
+        case '[':
+            item->type = cJSON_Array;
+            return true;
+
+        case '{':
+            item->type = cJSON_Object;
+            return true;
+
+        case 'l':
+            integer = (int64_t)tape->entries[index + 1];
+            number = (double)integer;
+            flags = cJSON_NumberIsInt;
+            break;
+
+        case 'u':
+            integer = (int64_t)tape->entries[index + 1];
+            number = (double)tape->entries[index + 1];
+            flags = cJSON_NumberIsInt | cJSON_NumberIsUint;
+            break;
+
+        case 'd':
+            memcpy(&number, &tape->entries[index + 1], sizeof(number));
+            break;
+
+        default:
+            return false;
     }
 
-    /* set "flag" to 1 if something needs to be escaped */
-    for (input_pointer = input; *input_pointer; input_pointer++)
+    /* like parse_number */
+    item->type = cJSON_Number | flags;
+    item->valuedouble = number;
+    item->valueint64 = integer;
+    if (number >= INT_MAX)
     {
-        switch (*input_pointer)
-        {
-            case '\"':
-            case '\\':
-            case '\b':
-            case '\f':
-            case '\n':
-            case '\r':
-            case '\t':
-                /* one character escape sequence */
-                escape_characters++;
-                break;
-            default:
-                if (*input_pointer < 32)
-                {
-                    /* UTF-16 escape sequence uXXXX */
-                    escape_characters += 5;
-                }
-                break;
-        }
+        item->valueint = INT_MAX;
     }
-    output_length = (size_t)(input_pointer - input) + escape_characters;
-
-    output = ensure(output_buffer, output_length + sizeof("\"\""));
-    if (output == NULL)
+    else if (number <= (double)INT_MIN)
     {
-        return false;
+        item->valueint = INT_MIN;
     }
-
-    /* no characters have to be escaped */
-    if (escape_characters == 0)
+    else
     {
-        output[0] = '\"';
-        memcpy(output + 1, input, output_length);
-        output[output_length + 1] = '\"';
-        output[output_length + 2] = '\0';
+        item->valueint = (int)number;
+    }
 
-        return true;
+    return true;
+}
+
+static cJSON *tape_to_item(const cJSON_Tape * const tape, const size_t index, const internal_hooks * const hooks)
+{
+    cJSON *item = NULL;
+    cJSON *child = NULL;
+    const char *name = NULL;
+    size_t end = 0;
+    size_t i = 0;
+
+    item = cJSON_New_Item(hooks);
+    if ((item == NULL) || !cJSON_TapeGetValue(tape, index, item))
+    {
+        goto fail;
     }
 
-    output[0] = '\"';
-    output_pointer = output + 1;
-    /* copy the string */
-    for (input_pointer = input; *input_pointer != '\0'; (void)input_pointer++, output_pointer++)
+    if (cJSON_IsString(item))
     {
-        if ((*input_pointer > 31) && (*input_pointer != '\"') && (*input_pointer != '\\'))
+        item->type &= ~cJSON_IsReference;
+        item->valuestring = (char*)cJSON_strdup((const unsigned char*)item->valuestring, hooks);
+        if (item->valuestring == NULL)
         {
-            /* normal character, copy */
-            *output_pointer = *input_pointer;
+            goto fail;
         }
-        else
+    }
+    else if (cJSON_IsArray(item) || cJSON_IsObject(item))
+    {
+        end = cJSON_TapeSkip(tape, index) - 1;
+        for (i = index + 1; i < end; i = cJSON_TapeSkip(tape, i))
         {
-            /* character needs to be escaped */
-            *output_pointer++ = '\\';
-            switch (*input_pointer)
+            name = NULL;
+            if (cJSON_IsObject(item))
+            {
+                name = cJSON_TapeGetString(tape, i++, NULL);
+            }
+            child = tape_to_item(tape, i, hooks);
+            if (child == NULL)
+            {
+                goto fail;
+            }
+            /* append, the head's prev is the tail like in a parsed tree */
+            if (item->child == NULL)
             {
-                case '\\':
-                    *output_pointer = '\\';
-                    break;
-                case '\"':
-                    *output_pointer = '\"';
-                    break;
-                case '\b':
-                    *output_pointer = 'b';
-                    break;
-                case '\f':
-                    *output_pointer = 'f';
-                    break;
-                case '\n':
-                    *output_pointer = 'n';
-                    break;
-                case '\r':
-                    *output_pointer = 'r';
-                    break;
-                case '\t':
-                    *output_pointer = 't';
-                    break;
-                default:
-                    /* escape and print as unicode codepoint */
-                    sprintf((char*)output_pointer, "u%04x", *input_pointer);
-                    output_pointer += 4;
-                    break;
+                item->child = child;
+            }
+            else
+            {
+                item->child->prev->next = child;
+                child->prev = item->child->prev;
+            }
+            item->child->prev = child;
+            item->child_count++;
+            if (name != NULL)
+            {
+                child->string = (char*)cJSON_strdup((const unsigned char*)name, hooks);
+                if (child->string == NULL)
+                {
+                    goto fail;
+                }
             }
         }
     }
-    output[output_length + 1] = '\"';
-    output[output_length + 2] = '\0';
 
-    return true;
+    return item;
+
+fail:
+    if (item != NULL)
+    {
+        cJSON_Delete(item);
+    }
+
+    return NULL;
 }
 
-/* Invoke print_string_ptr (which is useful) on an item. */
-static cJSON_bool print_string(const cJSON * const item, printbuffer * const p)
+CJSON_PUBLIC(cJSON *) cJSON_TapeToItem(const cJSON_Tape *tape, size_t index)
 {
-    return print_string_ptr((unsigned char*)item->valuestring, p);
+    if ((tape == NULL) || (index >= tape->length))
+    {
+        return NULL;
+    }
+
+    return tape_to_item(tape, index, current_hooks());
 }
 
-/* Predeclare these prototypes. */
-static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer);
-static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer);
-static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer);
+/* cJSON_Cursor states */
+#define CURSOR_VALUE         0 /* expecting a value */
+#define CURSOR_FIRST_ELEMENT 1 /* after '[', expecting a value or ']' */
+#define CURSOR_FIRST_MEMBER  2 /* after '{', expecting a name or '}' */
+#define CURSOR_MEMBER        3 /* after ',' within an object, expecting a name */
+#define CURSOR_NEXT          4 /* after a value, expecting ',' or the end of the array or object */
+#define CURSOR_END           5
+#define CURSOR_ERROR         6
 
-/* Utility to jump whitespace and cr/lf */
-static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
+#define cursor_in_object(cursor) ((((cursor)->objects[((cursor)->depth - 1) / 8]) >> (((cursor)->depth - 1) % 8)) & 1)
+
+static void cursor_skip_whitespace(cJSON_Cursor * const cursor)
 {
-    if ((buffer == NULL) || (buffer->content == NULL))
+    if (cursor->offset < cursor->length)
     {
-        return NULL;
+        cursor->offset += find_non_whitespace(cursor->content + cursor->offset, cursor->length - cursor->offset);
     }
+}
 
-    if (cannot_access_at_index(buffer, 0))
+/* Unescape the string literal at the offset into small or the buffer of the cursor. */
+static cJSON_bool cursor_string(cJSON_Cursor * const cursor)
+{
+    parse_buffer input_buffer = { 0, 0, 0, 0, { 0, 0, 0 }, 0, 0 };
+    const unsigned char *input_pointer = cursor->content + cursor->offset + 1;
+    const unsigned char *input_end = NULL;
+    unsigned char *output = cursor->small;
+    unsigned char *output_end = NULL;
+    size_t output_length = 0;
+
+    input_buffer.content = cursor->content;
+    input_buffer.length = cursor->length;
+    input_buffer.offset = cursor->offset;
+    if (!scan_string(&input_buffer, &input_end, &output_length))
     {
-        return buffer;
+        goto fail;
     }
 
-    while (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] <= 32))
+    if (output_length >= sizeof(cursor->small))
     {
-       buffer->offset++;
+        if (output_length >= cursor->buffer_size)
+        {
+            /* the old content is not needed anymore */
+            unsigned char *buffer = (unsigned char*)current_hooks()->allocate(output_length + sizeof(""));
+            if (buffer == NULL)
+            {
+                goto fail; /* allocation failure */
+            }
+            if (cursor->buffer != NULL)
+            {
+                current_hooks()->deallocate(cursor->buffer);
+            }
+            cursor->buffer = buffer;
+            cursor->buffer_size = output_length + sizeof("");
+        }
+        output = cursor->buffer;
     }
 
-    if (buffer->offset == buffer->length)
+    output_end = unescape_string(&input_pointer, input_end, output);
+    if (output_end == NULL)
     {
-        buffer->offset--;
+        goto fail;
     }
 
-    return buffer;
+    cursor->item.type = cJSON_String | cJSON_IsReference;
+    cursor->item.valuestring = (char*)output;
+    cursor->string_length = (size_t)(output_end - output);
+    cursor->offset = (size_t)(input_end - cursor->content) + 1;
+
+    return true;
+
+fail:
+    cursor->offset = (size_t)(input_pointer - cursor->content);
+    cursor->limit = input_buffer.limit;
+
+    return false;
 }
 
-/* skip the UTF-8 BOM (byte order mark) if it is at the beginning of a buffer */
-static parse_buffer *skip_utf8_bom(parse_buffer * const buffer)
+/* End of the innermost array or object at the offset. */
+static int cursor_close(cJSON_Cursor * const cursor, const unsigned char c)
 {
-    if ((buffer == NULL) || (buffer->content == NULL) || (buffer->offset != 0))
-    {
-        return NULL;
-    }
+    const cJSON_bool object = cursor_in_object(cursor);
 
-    if (can_access_at_index(buffer, 4) && (strncmp((const char*)buffer_at_offset(buffer), "\xEF\xBB\xBF", 3) == 0))
+    if (c != (object ? '}' : ']'))
     {
-        buffer->offset += 3;
+        cursor->state = CURSOR_ERROR;
+        return cJSON_TokenError;
     }
 
-    return buffer;
+    cursor->offset++;
+    cursor->depth--;
+    cursor->state = (cursor->depth == 0) ? CURSOR_END : CURSOR_NEXT;
+    cursor->item.type = object ? cJSON_Object : cJSON_Array;
+
+    return object ? cJSON_TokenEndObject : cJSON_TokenEndArray;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+CJSON_PUBLIC(void) cJSON_CursorInit(cJSON_Cursor *cursor, const char *value, size_t buffer_length)
 {
-    size_t buffer_length;
-
-    if (NULL == value)
+    if (cursor == NULL)
     {
-        return NULL;
+        return;
     }
 
-    /* Adding null character size due to require_null_terminated. */
-    buffer_length = strlen(value) + sizeof("");
+    memset(cursor, '\0', sizeof(cJSON_Cursor));
+    cursor->content = (const unsigned char*)value;
+    cursor->length = (value != NULL) ? buffer_length : 0;
+    cursor->limit = (cursor->length > thread_limits.max_length);
+    cursor->state = cursor->limit ? CURSOR_ERROR : CURSOR_VALUE;
 
-    return cJSON_ParseWithLengthOpts(value, buffer_length, return_parse_end, require_null_terminated);
+    /* skip the UTF-8 BOM like cJSON_Parse */
+    if ((cursor->length >= 3) && (strncmp(value, "\xEF\xBB\xBF", 3) == 0))
+    {
+        cursor->offset = 3;
+    }
 }
 
-/* Parse an object - create a new root, and populate. */
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+/* Same grammar as parse_value, one token at a time. */
+static int cursor_next(cJSON_Cursor * const cursor)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
-    cJSON *item = NULL;
-
-    /* reset error position */
-    global_error.json = NULL;
-    global_error.position = 0;
+    parse_buffer input_buffer = { 0, 0, 0, 0, { 0, 0, 0 }, 0, 0 };
+    const unsigned char *input = NULL;
+    size_t remaining = 0;
+    int token = cJSON_TokenError;
 
-    if (value == NULL || 0 == buffer_length)
+    if (cursor->state == CURSOR_END)
     {
-        goto fail;
+        return cJSON_TokenEnd;
+    }
+    if (cursor->state == CURSOR_ERROR)
+    {
+        return cJSON_TokenError;
     }
 
-    buffer.content = (const unsigned char*)value;
-    buffer.length = buffer_length; 
-    buffer.offset = 0;
-    buffer.hooks = global_hooks;
+    memset(&cursor->item, '\0', sizeof(cJSON));
+    cursor->string_length = 0;
 
-    item = cJSON_New_Item(&global_hooks);
-    if (item == NULL) /* memory fail */
+    cursor_skip_whitespace(cursor);
+    if (cursor->offset >= cursor->length)
     {
         goto fail;
     }
 
-    if (!parse_value(item, buffer_skip_whitespace(skip_utf8_bom(&buffer))))
+    switch (cursor->state)
     {
-        /* parse failure. ep is set. */
-        goto fail;
+        case CURSOR_NEXT:
+            if (cursor->content[cursor->offset] != ',')
+            {
+                return cursor_close(cursor, cursor->content[cursor->offset]);
+            }
+            cursor->offset++;
+            cursor->state = cursor_in_object(cursor) ? CURSOR_MEMBER : CURSOR_VALUE;
+            cursor_skip_whitespace(cursor);
+            if (cursor->offset >= cursor->length)
+            {
+                goto fail;
+            }
+            break;
+
+        case CURSOR_FIRST_ELEMENT:
+        case CURSOR_FIRST_MEMBER:
+            if ((cursor->content[cursor->offset] == ']') || (cursor->content[cursor->offset] == '}'))
+            {
+                return cursor_close(cursor, cursor->content[cursor->offset]);
+            }
+            cursor->state = (cursor->state == CURSOR_FIRST_MEMBER) ? CURSOR_MEMBER : CURSOR_VALUE;
+            break;
+
+        default:
+            break;
     }
 
-    /* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
-    if (require_null_terminated)
+    input = cursor->content + cursor->offset;
+    remaining = cursor->length - cursor->offset;
+
+    /* name of an object member, including the following colon */
+    if (cursor->state == CURSOR_MEMBER)
     {
-        buffer_skip_whitespace(&buffer);
-        if ((buffer.offset >= buffer.length) || buffer_at_offset(&buffer)[0] != '\0')
+        if ((input[0] != '\"') || !cursor_string(cursor))
         {
             goto fail;
         }
+        cursor_skip_whitespace(cursor);
+        if ((cursor->offset >= cursor->length) || (cursor->content[cursor->offset] != ':'))
+        {
+            goto fail; /* invalid object */
+        }
+        cursor->offset++;
+        cursor->state = CURSOR_VALUE;
+
+        return cJSON_TokenKey;
     }
-    if (return_parse_end)
+
+    if ((remaining >= 4) && (strncmp((const char*)input, "null", 4) == 0))
     {
-        *return_parse_end = (const char*)buffer_at_offset(&buffer);
+        cursor->item.type = cJSON_NULL;
+        cursor->offset += 4;
+        token = cJSON_TokenNull;
     }
-
-    return item;
-
-fail:
-    if (item != NULL)
+    else if ((remaining >= 5) && (strncmp((const char*)input, "false", 5) == 0))
     {
-        cJSON_Delete(item);
+        cursor->item.type = cJSON_False;
+        cursor->offset += 5;
+        token = cJSON_TokenFalse;
     }
-
-    if (value != NULL)
+    else if ((remaining >= 4) && (strncmp((const char*)input, "true", 4) == 0))
     {
-        error local_error;
-        local_error.json = (const unsigned char*)value;
-        local_error.position = 0;
-
-        if (buffer.offset < buffer.length)
+        cursor->item.type = cJSON_True;
+        cursor->item.valueint = 1;
+        cursor->offset += 4;
+        token = cJSON_TokenTrue;
+    }
+    else if (input[0] == '\"')
+    {
+        if (!cursor_string(cursor))
         {
-            local_error.position = buffer.offset;
+            goto fail;
         }
-        else if (buffer.length > 0)
+        token = cJSON_TokenString;
+    }
+    else if ((input[0] == '-') || ((input[0] >= '0') && (input[0] <= '9')))
+    {
+        input_buffer.content = cursor->content;
+        input_buffer.length = cursor->length;
+        input_buffer.offset = cursor->offset;
+        if (!parse_number(&cursor->item, &input_buffer))
         {
-            local_error.position = buffer.length - 1;
+            goto fail;
         }
-
-        if (return_parse_end != NULL)
+        cursor->offset = input_buffer.offset;
+        token = cJSON_TokenNumber;
+    }
+    else if ((input[0] == '[') || (input[0] == '{'))
+    {
+        if (cursor->depth >= thread_limits.max_depth)
         {
-            *return_parse_end = (const char*)local_error.json + local_error.position;
+            cursor->limit = true;
+            goto fail; /* to deeply nested */
         }
+        if (input[0] == '{')
+        {
+            cursor->objects[cursor->depth / 8] |= (unsigned char)(1u << (cursor->depth % 8));
+            cursor->item.type = cJSON_Object;
+            cursor->state = CURSOR_FIRST_MEMBER;
+            token = cJSON_TokenBeginObject;
+        }
+        else
+        {
+            cursor->objects[cursor->depth / 8] &= (unsigned char)~(1u << (cursor->depth % 8));
+            cursor->item.type = cJSON_Array;
+            cursor->state = CURSOR_FIRST_ELEMENT;
+            token = cJSON_TokenBeginArray;
+        }
+        cursor->depth++;
+        cursor->offset++;
 
-        global_error = local_error;
+        return token;
+    }
+    else
+    {
+        goto fail;
     }
 
-    return NULL;
+    cursor->state = (cursor->depth == 0) ? CURSOR_END : CURSOR_NEXT;
+
+    return token;
+
+fail:
+    memset(&cursor->item, '\0', sizeof(cJSON));
+    cursor->state = CURSOR_ERROR;
+
+    return cJSON_TokenError;
 }
 
-/* Default options for cJSON_Parse */
-CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
+CJSON_PUBLIC(int) cJSON_CursorNext(cJSON_Cursor *cursor)
 {
-    return cJSON_ParseWithOpts(value, 0, 0);
+    if (cursor == NULL)
+    {
+        return cJSON_TokenError;
+    }
+
+    cursor->token = cursor_next(cursor);
+
+    return cursor->token;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_length)
+CJSON_PUBLIC(int) cJSON_CursorSkip(cJSON_Cursor *cursor)
 {
-    return cJSON_ParseWithLengthOpts(value, buffer_length, 0, 0);
+    size_t depth = 0;
+    int token = cJSON_TokenEnd;
+
+    if ((cursor == NULL) || (cursor->state == CURSOR_ERROR))
+    {
+        return cJSON_TokenError;
+    }
+
+    depth = cursor->depth;
+    while ((cursor->depth >= depth) && (cursor->depth > 0))
+    {
+        token = cJSON_CursorNext(cursor);
+        if (token == cJSON_TokenError)
+        {
+            break;
+        }
+    }
+
+    return token;
+}
+
+CJSON_PUBLIC(void) cJSON_CursorFree(cJSON_Cursor *cursor)
+{
+    if ((cursor == NULL) || (cursor->buffer == NULL))
+    {
+        return;
+    }
+
+    if (cursor->item.valuestring == (char*)cursor->buffer)
+    {
+        cursor->item.valuestring = NULL;
+    }
+    current_hooks()->deallocate(cursor->buffer);
+    cursor->buffer = NULL;
+    cursor->buffer_size = 0;
 }
 
 #define cjson_min(a, b) (((a) < (b)) ? (a) : (b))
@@ -1245,12 +3343,12 @@ fail:
 /* Render a cJSON item/entity/structure to text. */
 CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item)
 {
-    return (char*)print(item, true, &global_hooks);
+    return (char*)print(item, true, current_hooks());
 }
 
 CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item)
 {
-    return (char*)print(item, false, &global_hooks);
+    return (char*)print(item, false, current_hooks());
 }
 
 CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt)
@@ -1262,7 +3360,7 @@ CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON
         return NULL;
     }
 
-    p.buffer = (unsigned char*)global_hooks.allocate((size_t)prebuffer);
+    p.buffer = (unsigned char*)current_hooks()->allocate((size_t)prebuffer);
     if (!p.buffer)
     {
         return NULL;
@@ -1272,11 +3370,11 @@ CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON
     p.offset = 0;
     p.noalloc = false;
     p.format = fmt;
-    p.hooks = global_hooks;
+    p.hooks = *current_hooks();
 
     if (!print_value(item, &p))
     {
-        global_hooks.deallocate(p.buffer);
+        current_hooks()->deallocate(p.buffer);
         return NULL;
     }
 
@@ -1297,7 +3395,7 @@ CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, cons
     p.offset = 0;
     p.noalloc = true;
     p.format = format;
-    p.hooks = global_hooks;
+    p.hooks = *current_hooks();
 
     return print_value(item, &p);
 }
@@ -1436,9 +3534,11 @@ static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buf
 {
     cJSON *head = NULL; /* head of the linked list */
     cJSON *current_item = NULL;
+    int count = 0;
 
-    if (input_buffer->depth >= CJSON_NESTING_LIMIT)
+    if (input_buffer->depth >= thread_limits.max_depth)
     {
+        input_buffer->limit = true;
         return false; /* to deeply nested */
     }
     input_buffer->depth++;
@@ -1469,8 +3569,15 @@ static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buf
     /* loop through the comma separated array elements */
     do
     {
+        cJSON *new_item = NULL;
+        if ((size_t)count >= thread_limits.max_elements)
+        {
+            input_buffer->limit = true;
+            goto fail;
+        }
+
         /* allocate next item */
-        cJSON *new_item = cJSON_New_Item(&(input_buffer->hooks));
+        new_item = cJSON_New_Item(&(input_buffer->hooks));
         if (new_item == NULL)
         {
             goto fail; /* allocation failure */
@@ -1489,6 +3596,7 @@ static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buf
             new_item->prev = current_item;
             current_item = new_item;
         }
+        count++;
 
         /* parse next value */
         input_buffer->offset++;
@@ -1515,6 +3623,7 @@ success:
 
     item->type = cJSON_Array;
     item->child = head;
+    item->child_count = count;
 
     input_buffer->offset++;
 
@@ -1542,8 +3651,9 @@ static cJSON_bool print_array(const cJSON * const item, printbuffer * const outp
     }
 
     /* Compose the output array. */
-    /* opening square bracket */
-    output_pointer = ensure(output_buffer, 1);
+    /* opening square bracket, growing buffers reserve a character and a comma per element */
+    length = output_buffer->noalloc ? 0 : 2 * (size_t)item->child_count;
+    output_pointer = ensure(output_buffer, length + 1);
     if (output_pointer == NULL)
     {
         return false;
@@ -1596,9 +3706,11 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
 {
     cJSON *head = NULL; /* linked list head */
     cJSON *current_item = NULL;
+    int count = 0;
 
-    if (input_buffer->depth >= CJSON_NESTING_LIMIT)
+    if (input_buffer->depth >= thread_limits.max_depth)
     {
+        input_buffer->limit = true;
         return false; /* to deeply nested */
     }
     input_buffer->depth++;
@@ -1627,8 +3739,15 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
     /* loop through the comma separated array elements */
     do
     {
+        cJSON *new_item = NULL;
+        if ((size_t)count >= thread_limits.max_members)
+        {
+            input_buffer->limit = true;
+            goto fail;
+        }
+
         /* allocate next item */
-        cJSON *new_item = cJSON_New_Item(&(input_buffer->hooks));
+        new_item = cJSON_New_Item(&(input_buffer->hooks));
         if (new_item == NULL)
         {
             goto fail; /* allocation failure */
@@ -1647,6 +3766,7 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
             new_item->prev = current_item;
             current_item = new_item;
         }
+        count++;
 
         /* parse the name of the child */
         input_buffer->offset++;
@@ -1660,6 +3780,11 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
         /* swap valuestring and string, because we parsed the name */
         current_item->string = current_item->valuestring;
         current_item->valuestring = NULL;
+        if (input_buffer->in_situ != NULL)
+        {
+            /* keep cJSON_Delete away from the name, it is owned by the input buffer */
+            current_item->type = cJSON_StringIsConst;
+        }
 
         if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
         {
@@ -1673,6 +3798,10 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
         {
             goto fail; /* failed to parse value */
         }
+        if (input_buffer->in_situ != NULL)
+        {
+            current_item->type |= cJSON_StringIsConst;
+        }
         buffer_skip_whitespace(input_buffer);
     }
     while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
@@ -1691,6 +3820,7 @@ success:
 
     item->type = cJSON_Object;
     item->child = head;
+    item->child_count = count;
 
     input_buffer->offset++;
     return true;
@@ -1718,7 +3848,8 @@ static cJSON_bool print_object(const cJSON * const item, printbuffer * const out
 
     /* Compose the output: */
     length = (size_t) (output_buffer->format ? 2 : 1); /* fmt: {\n */
-    output_pointer = ensure(output_buffer, length + 1);
+    /* growing buffers reserve "":0, for every member */
+    output_pointer = ensure(output_buffer, length + 1 + (output_buffer->noalloc ? 0 : 5 * (size_t)item->child_count));
     if (output_pointer == NULL)
     {
         return false;
@@ -1821,32 +3952,20 @@ static cJSON_bool print_object(const cJSON * const item, printbuffer * const out
 /* Get Array size/item / object item. */
 CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array)
 {
-    cJSON *child = NULL;
-    size_t size = 0;
-
     if (array == NULL)
     {
         return 0;
     }
 
-    child = array->child;
-
-    while(child != NULL)
-    {
-        size++;
-        child = child->next;
-    }
-
-    /* FIXME: Can overflow here. Cannot be fixed without breaking the API */
-
-    return (int)size;
+    /* every function linking or unlinking children keeps the count */
+    return array->child_count;
 }
 
 static cJSON* get_array_item(const cJSON *array, size_t index)
 {
     cJSON *current_child = NULL;
 
-    if (array == NULL)
+    if ((array == NULL) || (index >= (size_t)array->child_count))
     {
         return NULL;
     }
@@ -1966,6 +4085,7 @@ static cJSON_bool add_item_to_array(cJSON *array, cJSON *item)
         array->child = item;
         item->prev = item;
         item->next = NULL;
+        array->child_count++;
     }
     else
     {
@@ -1974,6 +4094,7 @@ static cJSON_bool add_item_to_array(cJSON *array, cJSON *item)
         {
             suffix_object(child->prev, item);
             array->child->prev = item;
+            array->child_count++;
         }
     }
 
@@ -2041,13 +4162,13 @@ static cJSON_bool add_item_to_object(cJSON * const object, const char * const st
 
 CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item)
 {
-    return add_item_to_object(object, string, item, &global_hooks, false);
+    return add_item_to_object(object, string, item, current_hooks(), false);
 }
 
 /* Add an item to an object with constant string as key */
 CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToObjectCS(cJSON *object, const char *string, cJSON *item)
 {
-    return add_item_to_object(object, string, item, &global_hooks, true);
+    return add_item_to_object(object, string, item, current_hooks(), true);
 }
 
 CJSON_PUBLIC(cJSON_bool) cJSON_AddItemReferenceToArray(cJSON *array, cJSON *item)
@@ -2057,7 +4178,7 @@ CJSON_PUBLIC(cJSON_bool) cJSON_AddItemReferenceToArray(cJSON *array, cJSON *item
         return false;
     }
 
-    return add_item_to_array(array, create_reference(item, &global_hooks));
+    return add_item_to_array(array, create_reference(item, current_hooks()));
 }
 
 CJSON_PUBLIC(cJSON_bool) cJSON_AddItemReferenceToObject(cJSON *object, const char *string, cJSON *item)
@@ -2067,13 +4188,13 @@ CJSON_PUBLIC(cJSON_bool) cJSON_AddItemReferenceToObject(cJSON *object, const cha
         return false;
     }
 
-    return add_item_to_object(object, string, create_reference(item, &global_hooks), &global_hooks, false);
+    return add_item_to_object(object, string, create_reference(item, current_hooks()), current_hooks(), false);
 }
 
 CJSON_PUBLIC(cJSON*) cJSON_AddNullToObject(cJSON * const object, const char * const name)
 {
     cJSON *null = cJSON_CreateNull();
-    if (add_item_to_object(object, name, null, &global_hooks, false))
+    if (add_item_to_object(object, name, null, current_hooks(), false))
     {
         return null;
     }
@@ -2085,7 +4206,7 @@ CJSON_PUBLIC(cJSON*) cJSON_AddNullToObject(cJSON * const object, const char * co
 CJSON_PUBLIC(cJSON*) cJSON_AddTrueToObject(cJSON * const object, const char * const name)
 {
     cJSON *true_item = cJSON_CreateTrue();
-    if (add_item_to_object(object, name, true_item, &global_hooks, false))
+    if (add_item_to_object(object, name, true_item, current_hooks(), false))
     {
         return true_item;
     }
@@ -2097,7 +4218,7 @@ CJSON_PUBLIC(cJSON*) cJSON_AddTrueToObject(cJSON * const object, const char * co
 CJSON_PUBLIC(cJSON*) cJSON_AddFalseToObject(cJSON * const object, const char * const name)
 {
     cJSON *false_item = cJSON_CreateFalse();
-    if (add_item_to_object(object, name, false_item, &global_hooks, false))
+    if (add_item_to_object(object, name, false_item, current_hooks(), false))
     {
         return false_item;
     }
@@ -2109,7 +4230,7 @@ CJSON_PUBLIC(cJSON*) cJSON_AddFalseToObject(cJSON * const object, const char * c
 CJSON_PUBLIC(cJSON*) cJSON_AddBoolToObject(cJSON * const object, const char * const name, const cJSON_bool boolean)
 {
     cJSON *bool_item = cJSON_CreateBool(boolean);
-    if (add_item_to_object(object, name, bool_item, &global_hooks, false))
+    if (add_item_to_object(object, name, bool_item, current_hooks(), false))
     {
         return bool_item;
     }
@@ -2121,7 +4242,7 @@ CJSON_PUBLIC(cJSON*) cJSON_AddBoolToObject(cJSON * const object, const char * co
 CJSON_PUBLIC(cJSON*) cJSON_AddNumberToObject(cJSON * const object, const char * const name, const double number)
 {
     cJSON *number_item = cJSON_CreateNumber(number);
-    if (add_item_to_object(object, name, number_item, &global_hooks, false))
+    if (add_item_to_object(object, name, number_item, current_hooks(), false))
     {
         return number_item;
     }
@@ -2133,7 +4254,7 @@ CJSON_PUBLIC(cJSON*) cJSON_AddNumberToObject(cJSON * const object, const char *
 CJSON_PUBLIC(cJSON*) cJSON_AddStringToObject(cJSON * const object, const char * const name, const char * const string)
 {
     cJSON *string_item = cJSON_CreateString(string);
-    if (add_item_to_object(object, name, string_item, &global_hooks, false))
+    if (add_item_to_object(object, name, string_item, current_hooks(), false))
     {
         return string_item;
     }
@@ -2145,7 +4266,7 @@ CJSON_PUBLIC(cJSON*) cJSON_AddStringToObject(cJSON * const object, const char *
 CJSON_PUBLIC(cJSON*) cJSON_AddRawToObject(cJSON * const object, const char * const name, const char * const raw)
 {
     cJSON *raw_item = cJSON_CreateRaw(raw);
-    if (add_item_to_object(object, name, raw_item, &global_hooks, false))
+    if (add_item_to_object(object, name, raw_item, current_hooks(), false))
     {
         return raw_item;
     }
@@ -2157,7 +4278,7 @@ CJSON_PUBLIC(cJSON*) cJSON_AddRawToObject(cJSON * const object, const char * con
 CJSON_PUBLIC(cJSON*) cJSON_AddObjectToObject(cJSON * const object, const char * const name)
 {
     cJSON *object_item = cJSON_CreateObject();
-    if (add_item_to_object(object, name, object_item, &global_hooks, false))
+    if (add_item_to_object(object, name, object_item, current_hooks(), false))
     {
         return object_item;
     }
@@ -2169,7 +4290,7 @@ CJSON_PUBLIC(cJSON*) cJSON_AddObjectToObject(cJSON * const object, const char *
 CJSON_PUBLIC(cJSON*) cJSON_AddArrayToObject(cJSON * const object, const char * const name)
 {
     cJSON *array = cJSON_CreateArray();
-    if (add_item_to_object(object, name, array, &global_hooks, false))
+    if (add_item_to_object(object, name, array, current_hooks(), false))
     {
         return array;
     }
@@ -2207,6 +4328,8 @@ CJSON_PUBLIC(cJSON *) cJSON_DetachItemViaPointer(cJSON *parent, cJSON * const it
         parent->child->prev = item->prev;
     }
 
+    parent->child_count--;
+
     /* make sure the detached item doesn't point anywhere anymore */
     item->prev = NULL;
     item->next = NULL;
@@ -2280,6 +4403,7 @@ CJSON_PUBLIC(cJSON_bool) cJSON_InsertItemInArray(cJSON *array, int which, cJSON
     {
         newitem->prev->next = newitem;
     }
+    array->child_count++;
     return true;
 }
 
@@ -2354,7 +4478,7 @@ static cJSON_bool replace_item_in_object(cJSON *object, const char *string, cJSO
     {
         cJSON_free(replacement->string);
     }
-    replacement->string = (char*)cJSON_strdup((const unsigned char*)string, &global_hooks);
+    replacement->string = (char*)cJSON_strdup((const unsigned char*)string, current_hooks());
     replacement->type &= ~cJSON_StringIsConst;
 
     return cJSON_ReplaceItemViaPointer(object, get_object_item(object, string, case_sensitive), replacement);
@@ -2373,7 +4497,7 @@ CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemInObjectCaseSensitive(cJSON *object, c
 /* Create basic types: */
 CJSON_PUBLIC(cJSON *) cJSON_CreateNull(void)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
+    cJSON *item = cJSON_New_Item(current_hooks());
     if(item)
     {
         item->type = cJSON_NULL;
@@ -2384,7 +4508,7 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateNull(void)
 
 CJSON_PUBLIC(cJSON *) cJSON_CreateTrue(void)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
+    cJSON *item = cJSON_New_Item(current_hooks());
     if(item)
     {
         item->type = cJSON_True;
@@ -2395,7 +4519,7 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateTrue(void)
 
 CJSON_PUBLIC(cJSON *) cJSON_CreateFalse(void)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
+    cJSON *item = cJSON_New_Item(current_hooks());
     if(item)
     {
         item->type = cJSON_False;
@@ -2406,7 +4530,7 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateFalse(void)
 
 CJSON_PUBLIC(cJSON *) cJSON_CreateBool(cJSON_bool boolean)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
+    cJSON *item = cJSON_New_Item(current_hooks());
     if(item)
     {
         item->type = boolean ? cJSON_True : cJSON_False;
@@ -2417,7 +4541,7 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateBool(cJSON_bool boolean)
 
 CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(double num)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
+    cJSON *item = cJSON_New_Item(current_hooks());
     if(item)
     {
         item->type = cJSON_Number;
@@ -2441,13 +4565,37 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(double num)
     return item;
 }
 
+CJSON_PUBLIC(cJSON *) cJSON_CreateInt64(int64_t num)
+{
+    cJSON *item = cJSON_CreateNumber((double)num);
+    if(item)
+    {
+        item->type |= cJSON_NumberIsInt;
+        item->valueint64 = num;
+    }
+
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateUint64(uint64_t num)
+{
+    cJSON *item = cJSON_CreateNumber((double)num);
+    if(item)
+    {
+        item->type |= (num > (uint64_t)INT64_MAX) ? (cJSON_NumberIsInt | cJSON_NumberIsUint) : cJSON_NumberIsInt;
+        item->valueint64 = (num > (uint64_t)INT64_MAX) ? ((int64_t)(num - ((uint64_t)INT64_MAX + 1)) + INT64_MIN) : (int64_t)num;
+    }
+
+    return item;
+}
+
 CJSON_PUBLIC(cJSON *) cJSON_CreateString(const char *string)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
+    cJSON *item = cJSON_New_Item(current_hooks());
     if(item)
     {
         item->type = cJSON_String;
-        item->valuestring = (char*)cJSON_strdup((const unsigned char*)string, &global_hooks);
+        item->valuestring = (char*)cJSON_strdup((const unsigned char*)string, current_hooks());
         if(!item->valuestring)
         {
             cJSON_Delete(item);
@@ -2460,7 +4608,7 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateString(const char *string)
 
 CJSON_PUBLIC(cJSON *) cJSON_CreateStringReference(const char *string)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
+    cJSON *item = cJSON_New_Item(current_hooks());
     if (item != NULL)
     {
         item->type = cJSON_String | cJSON_IsReference;
@@ -2470,22 +4618,38 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateStringReference(const char *string)
     return item;
 }
 
+/* count a borrowed chain once, references don't see later changes to it anyway */
+static int count_children(const cJSON *child)
+{
+    int count = 0;
+
+    while (child != NULL)
+    {
+        count++;
+        child = child->next;
+    }
+
+    return count;
+}
+
 CJSON_PUBLIC(cJSON *) cJSON_CreateObjectReference(const cJSON *child)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
+    cJSON *item = cJSON_New_Item(current_hooks());
     if (item != NULL) {
         item->type = cJSON_Object | cJSON_IsReference;
         item->child = (cJSON*)cast_away_const(child);
+        item->child_count = count_children(child);
     }
 
     return item;
 }
 
 CJSON_PUBLIC(cJSON *) cJSON_CreateArrayReference(const cJSON *child) {
-    cJSON *item = cJSON_New_Item(&global_hooks);
+    cJSON *item = cJSON_New_Item(current_hooks());
     if (item != NULL) {
         item->type = cJSON_Array | cJSON_IsReference;
         item->child = (cJSON*)cast_away_const(child);
+        item->child_count = count_children(child);
     }
 
     return item;
@@ -2493,11 +4657,11 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateArrayReference(const cJSON *child) {
 
 CJSON_PUBLIC(cJSON *) cJSON_CreateRaw(const char *raw)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
+    cJSON *item = cJSON_New_Item(current_hooks());
     if(item)
     {
         item->type = cJSON_Raw;
-        item->valuestring = (char*)cJSON_strdup((const unsigned char*)raw, &global_hooks);
+        item->valuestring = (char*)cJSON_strdup((const unsigned char*)raw, current_hooks());
         if(!item->valuestring)
         {
             cJSON_Delete(item);
@@ -2510,7 +4674,7 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateRaw(const char *raw)
 
 CJSON_PUBLIC(cJSON *) cJSON_CreateArray(void)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
+    cJSON *item = cJSON_New_Item(current_hooks());
     if(item)
     {
         item->type=cJSON_Array;
@@ -2521,7 +4685,7 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateArray(void)
 
 CJSON_PUBLIC(cJSON *) cJSON_CreateObject(void)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
+    cJSON *item = cJSON_New_Item(current_hooks());
     if (item)
     {
         item->type = cJSON_Object;
@@ -2563,6 +4727,7 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateIntArray(const int *numbers, int count)
         p = n;
     }
     a->child->prev = n;
+    a->child_count = count;
 
     return a;
 }
@@ -2600,6 +4765,7 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateFloatArray(const float *numbers, int count)
         p = n;
     }
     a->child->prev = n;
+    a->child_count = count;
 
     return a;
 }
@@ -2637,6 +4803,7 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateDoubleArray(const double *numbers, int count)
         p = n;
     }
     a->child->prev = n;
+    a->child_count = count;
 
     return a;
 }
@@ -2674,6 +4841,7 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateStringArray(const char *const *strings, int co
         p = n;
     }
     a->child->prev = n;
+    a->child_count = count;
 
     return a;
 }
@@ -2692,7 +4860,7 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
         goto fail;
     }
     /* Create new item */
-    newitem = cJSON_New_Item(&global_hooks);
+    newitem = cJSON_New_Item(current_hooks());
     if (!newitem)
     {
         goto fail;
@@ -2701,9 +4869,10 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
     newitem->type = item->type & (~cJSON_IsReference);
     newitem->valueint = item->valueint;
     newitem->valuedouble = item->valuedouble;
+    newitem->valueint64 = item->valueint64;
     if (item->valuestring)
     {
-        newitem->valuestring = (char*)cJSON_strdup((unsigned char*)item->valuestring, &global_hooks);
+        newitem->valuestring = (char*)cJSON_strdup((unsigned char*)item->valuestring, current_hooks());
         if (!newitem->valuestring)
         {
             goto fail;
@@ -2711,7 +4880,7 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
     }
     if (item->string)
     {
-        newitem->string = (item->type&cJSON_StringIsConst) ? item->string : (char*)cJSON_strdup((unsigned char*)item->string, &global_hooks);
+        newitem->string = (item->type&cJSON_StringIsConst) ? item->string : (char*)cJSON_strdup((unsigned char*)item->string, current_hooks());
         if (!newitem->string)
         {
             goto fail;
@@ -2744,6 +4913,7 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
             newitem->child = newchild;
             next = newchild;
         }
+        newitem->child_count++;
         child = child->next;
     }
     if (newitem && newitem->child)
@@ -3086,10 +5256,15 @@ CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * cons
 
 CJSON_PUBLIC(void *) cJSON_malloc(size_t size)
 {
-    return global_hooks.allocate(size);
+    return current_hooks()->allocate(size);
 }
 
 CJSON_PUBLIC(void) cJSON_free(void *object)
+{
+    current_hooks()->deallocate(object);
+}
+
+CJSON_PUBLIC(void) cJSON_GlobalFree(void *object)
 {
     global_hooks.deallocate(object);
 }
@@ -84,6 +84,7 @@ then using the CJSON_API_VISIBILITY flag to "export" the same symbols the way CJ
 #define CJSON_VERSION_PATCH 14
 
 #include <stddef.h>
+#include <stdint.h>
 
 /* cJSON Types: */
 #define cJSON_Invalid (0)
@@ -98,6 +99,10 @@ then using the CJSON_API_VISIBILITY flag to "export" the same symbols the way CJ
 
 #define cJSON_IsReference 256
 #define cJSON_StringIsConst 512
+/* valueint64 holds the exact value of an integer number */
+#define cJSON_NumberIsInt 1024
+/* valueint64 holds the exact value of an integer number > INT64_MAX as (int64_t) conversion of the uint64_t */
+#define cJSON_NumberIsUint 2048
 
 /* The cJSON structure: */
 typedef struct cJSON
@@ -117,9 +122,14 @@ typedef struct cJSON
     int valueint;
     /* The item's number, if type==cJSON_Number */
     double valuedouble;
+    /* The item's exact integer value, if type has cJSON_NumberIsInt set (use cJSON_GetInt64Value/cJSON_GetUint64Value) */
+    int64_t valueint64;
 
     /* The item's name string, if this item is the child of, or is in the list of subitems of an object. */
     char *string;
+
+    /* The number of items in the child chain, kept up to date by all cJSON functions (see cJSON_GetArraySize). */
+    int child_count;
 } cJSON;
 
 typedef struct cJSON_Hooks
@@ -129,19 +139,102 @@ typedef struct cJSON_Hooks
       void (CJSON_CDECL *free_fn)(void *ptr);
 } cJSON_Hooks;
 
+typedef struct cJSON_ThreadHooks
+{
+      void *(CJSON_CDECL *malloc_fn)(size_t sz);
+      void (CJSON_CDECL *free_fn)(void *ptr);
+      /* optional, without it print buffers are grown with malloc_fn, memcpy and free_fn */
+      void *(CJSON_CDECL *realloc_fn)(void *ptr, size_t sz);
+} cJSON_ThreadHooks;
+
 typedef int cJSON_bool;
 
+/* Compact, read-only alternative to the cJSON tree: a flat array ("tape") of 64 bit entries, each with a type character in the
+ * upper 8 bits and a payload in the lower 56 bits (see cJSON_TapeType and cJSON_TapePayload):
+ *   '{' '['      start of an object/array: index of the entry following the matching end in bits 0-31, number of elements
+ *                (saturated at cJSON_TapeCountMax) in bits 32-55. Object members are a '"' name entry followed by the value.
+ *   '}' ']'      end of an object/array: index of the matching start
+ *   '"'          string: offset of its length (uint32_t, native byte order) in strings, followed by its bytes and a zero
+ *   'l' 'u' 'd'  int64_t, uint64_t (> INT64_MAX) or double number, the bits of the value are the next entry
+ *   't' 'f' 'n'  true, false, null
+ * The parsed value starts at entry 0. */
+typedef struct cJSON_Tape
+{
+    uint64_t *entries;
+    size_t length;
+    unsigned char *strings;
+    size_t strings_length;
+} cJSON_Tape;
+
+#define cJSON_TapeType(entry) ((unsigned char)((entry) >> 56))
+#define cJSON_TapePayload(entry) ((entry) & UINT64_C(0xFFFFFFFFFFFFFF))
+#define cJSON_TapeCountMax 0xFFFFFF
+
 /* Limits how deeply nested arrays/objects can be before cJSON rejects to parse them.
  * This is to prevent stack overflows. */
 #ifndef CJSON_NESTING_LIMIT
 #define CJSON_NESTING_LIMIT 1000
 #endif
 
+/* What the parse functions of a thread accept (see cJSON_InitThreadLimits), zero means no limit. */
+typedef struct cJSON_Limits
+{
+    size_t max_length;   /* buffer_length of the input */
+    size_t max_depth;    /* nesting of arrays and objects, CJSON_NESTING_LIMIT applies anyway */
+    size_t max_members;  /* members of an object */
+    size_t max_elements; /* elements of an array */
+    size_t max_string;   /* bytes of a string or member name, checked before decoding (a \u escape counts as five) */
+} cJSON_Limits;
+
+/* Tokens returned by cJSON_CursorNext */
+#define cJSON_TokenEnd         0 /* the value is complete */
+#define cJSON_TokenError       1 /* invalid input (or out of memory) at cJSON_Cursor.offset */
+#define cJSON_TokenBeginObject 2
+#define cJSON_TokenEndObject   3
+#define cJSON_TokenBeginArray  4
+#define cJSON_TokenEndArray    5
+#define cJSON_TokenKey         6 /* name of an object member, the value follows */
+#define cJSON_TokenString      7
+#define cJSON_TokenNumber      8
+#define cJSON_TokenTrue        9
+#define cJSON_TokenFalse       10
+#define cJSON_TokenNull        11
+
+/* Pull parser state (see cJSON_CursorInit). item holds the value of the last token like a parsed item would: valuestring
+ * (string_length bytes, zero terminated) of key and string tokens, the number of number tokens (cJSON_GetInt64Value works) and
+ * the type of all of them. valuestring is only valid until the next call. */
+typedef struct cJSON_Cursor
+{
+    const unsigned char *content;
+    size_t length;
+    size_t offset; /* of the next token, or of the error */
+    size_t depth;
+    int state;
+    int token; /* the last token returned by cJSON_CursorNext */
+    cJSON_bool limit; /* the error is a limit of cJSON_InitThreadLimits rather than invalid input */
+    unsigned char objects[(CJSON_NESTING_LIMIT + 7) / 8]; /* a bit per nesting level, set for objects */
+    cJSON item;
+    size_t string_length;
+    unsigned char *buffer; /* strings that don't fit into small */
+    size_t buffer_size;
+    unsigned char small[64];
+} cJSON_Cursor;
+
 /* returns the version of cJSON as a string */
 CJSON_PUBLIC(const char*) cJSON_Version(void);
 
 /* Supply malloc, realloc and free functions to cJSON */
 CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks);
+/* Supply malloc, realloc and free functions for the calling thread only, taking precedence over cJSON_InitHooks. NULL switches
+ * back to the global hooks. Items must be deleted with the hooks they were allocated with. */
+CJSON_PUBLIC(void) cJSON_InitThreadHooks(const cJSON_ThreadHooks* hooks);
+/* Copy the hooks of the calling thread to hooks (e.g. to restore them later), false if it uses the global ones. */
+CJSON_PUBLIC(cJSON_bool) cJSON_GetThreadHooks(cJSON_ThreadHooks* hooks);
+/* Limit the input the parse functions accept on the calling thread: parsing stops at the first excess like at invalid input, before
+ * allocating anything for it. The cursor checks all but max_members and max_elements. NULL lifts the limits. */
+CJSON_PUBLIC(void) cJSON_InitThreadLimits(const cJSON_Limits* limits);
+/* Copy the limits of the calling thread to limits (e.g. to restore them later), zero where there is none. */
+CJSON_PUBLIC(void) cJSON_GetThreadLimits(cJSON_Limits* limits);
 
 /* Memory Management: the caller is always responsible to free the results from all variants of cJSON_Parse (with cJSON_Delete) and cJSON_Print (with stdlib free, cJSON_Hooks.free_fn, or cJSON_free as appropriate). The exception is cJSON_PrintPreallocated, where the caller has full responsibility of the buffer. */
 /* Supply a block of JSON, and this returns a cJSON object you can interrogate. */
@@ -151,6 +244,32 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_len
 /* If you supply a ptr in return_parse_end and parsing fails, then return_parse_end will contain a pointer to the error so will match cJSON_GetErrorPtr(). */
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
+/* ParseInSitu decodes strings within the given buffer instead of copying them: valuestring and string of the result point into
+ * value, which is modified and must outlive the result (and everything that references its strings, e.g. cJSON_Duplicate keeps
+ * the names of object members). Such strings are flagged cJSON_IsReference and cJSON_StringIsConst respectively. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
+/* ParseTape parses into a cJSON_Tape (to be deleted with cJSON_DeleteTape) instead of a tree: two allocations that grow as
+ * needed instead of one per value. return_parse_end and the error pointer are set like with ParseWithOpts. */
+CJSON_PUBLIC(cJSON_Tape *) cJSON_ParseTape(const char *value, size_t buffer_length, const char **return_parse_end);
+CJSON_PUBLIC(void) cJSON_DeleteTape(cJSON_Tape *tape);
+/* Index of the entry following the value at index, arrays and objects are skipped as a whole. */
+CJSON_PUBLIC(size_t) cJSON_TapeSkip(const cJSON_Tape *tape, size_t index);
+/* The string at index and its length (may be NULL), NULL if it isn't a string. */
+CJSON_PUBLIC(const char *) cJSON_TapeGetString(const cJSON_Tape *tape, size_t index, size_t *length);
+/* Fill item (e.g. on the stack) with the value at index without allocating anything: strings are references into the tape,
+ * arrays and objects get no children. Returns false if index is out of range. */
+CJSON_PUBLIC(cJSON_bool) cJSON_TapeGetValue(const cJSON_Tape *tape, size_t index, cJSON *item);
+/* Create a tree (to be deleted with cJSON_Delete) of the value at index. */
+CJSON_PUBLIC(cJSON *) cJSON_TapeToItem(const cJSON_Tape *tape, size_t index);
+/* Step through value token by token instead of building anything: memory use doesn't depend on the size of the input, only
+ * strings longer than cJSON_Cursor.small are decoded into a buffer that is released by cJSON_CursorFree. value must outlive the
+ * cursor. */
+CJSON_PUBLIC(void) cJSON_CursorInit(cJSON_Cursor *cursor, const char *value, size_t buffer_length);
+/* The next token (cJSON_Token*), cJSON_TokenEnd once the value is complete, cJSON_TokenError from the first error on. */
+CJSON_PUBLIC(int) cJSON_CursorNext(cJSON_Cursor *cursor);
+/* Skip the rest of the innermost array or object, returns its end token (cJSON_TokenEnd if none is open) or cJSON_TokenError. */
+CJSON_PUBLIC(int) cJSON_CursorSkip(cJSON_Cursor *cursor);
+CJSON_PUBLIC(void) cJSON_CursorFree(cJSON_Cursor *cursor);
 
 /* Render a cJSON entity to text for transfer/storage. */
 CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item);
@@ -172,12 +291,17 @@ CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index);
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItem(const cJSON * const object, const char * const string);
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItemCaseSensitive(const cJSON * const object, const char * const string);
 CJSON_PUBLIC(cJSON_bool) cJSON_HasObjectItem(const cJSON *object, const char *string);
-/* For analysing failed parses. This returns a pointer to the parse error. You'll probably need to look a few chars back to make sense of it. Defined when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds. */
+/* For analysing failed parses. This returns a pointer to the parse error. You'll probably need to look a few chars back to make sense of it. Defined when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds. Kept per thread. */
 CJSON_PUBLIC(const char *) cJSON_GetErrorPtr(void);
+/* Whether the last failed parse of the calling thread stopped at a limit (see cJSON_InitThreadLimits) instead of invalid input. */
+CJSON_PUBLIC(cJSON_bool) cJSON_GetErrorLimit(void);
 
 /* Check item type and return its value */
 CJSON_PUBLIC(char *) cJSON_GetStringValue(const cJSON * const item);
 CJSON_PUBLIC(double) cJSON_GetNumberValue(const cJSON * const item);
+/* Get the value of an integer number exactly, returns false if item isn't a number with an integer value in range */
+CJSON_PUBLIC(cJSON_bool) cJSON_GetInt64Value(const cJSON * const item, int64_t * const value);
+CJSON_PUBLIC(cJSON_bool) cJSON_GetUint64Value(const cJSON * const item, uint64_t * const value);
 
 /* These functions check the type of an item */
 CJSON_PUBLIC(cJSON_bool) cJSON_IsInvalid(const cJSON * const item);
@@ -197,6 +321,9 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateTrue(void);
 CJSON_PUBLIC(cJSON *) cJSON_CreateFalse(void);
 CJSON_PUBLIC(cJSON *) cJSON_CreateBool(cJSON_bool boolean);
 CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(double num);
+/* create numbers that keep their exact integer value (also when printed) */
+CJSON_PUBLIC(cJSON *) cJSON_CreateInt64(int64_t num);
+CJSON_PUBLIC(cJSON *) cJSON_CreateUint64(uint64_t num);
 CJSON_PUBLIC(cJSON *) cJSON_CreateString(const char *string);
 /* raw json */
 CJSON_PUBLIC(cJSON *) cJSON_CreateRaw(const char *raw);
@@ -285,6 +412,8 @@ CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring)
 /* malloc/free objects using the malloc/free functions that have been set with cJSON_InitHooks */
 CJSON_PUBLIC(void *) cJSON_malloc(size_t size);
 CJSON_PUBLIC(void) cJSON_free(void *object);
+/* free with the cJSON_InitHooks function even while thread hooks are installed, e.g. from a free_fn thread hook */
+CJSON_PUBLIC(void) cJSON_GlobalFree(void *object);
 
 #ifdef __cplusplus
 }
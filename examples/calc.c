@@ -3,26 +3,35 @@
 #include "cJRPC2.h"
 
 #include <errno.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+/* operands of all methods */
+struct calc_args {
+	double a;
+	double b;
+};
+
+static const struct cjrpc2_param_desc calc_params[] = {
+	{"a", CJRPC2_PARAM_DOUBLE, offsetof(struct calc_args, a), 0, 0, 0},
+	{"b", CJRPC2_PARAM_DOUBLE, offsetof(struct calc_args, b), 0, 0, 0},
+	{NULL, 0, 0, 0, 0, 0},
+};
+
 int impl_add(const cJSON *params, cJSON **resp)
 {
-	double a, b, result;
+	struct calc_args args;
+	double result;
 
-	/* get parameters */
-	if (PARAM_OK != cjrpc2_get_param_double(params, "a", &a)) {
-		*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, "Invalid/missing param 'a'", NULL);
-		return CJRPC2_RET_ERROR;
-	}
-	if (PARAM_OK != cjrpc2_get_param_double(params, "b", &b)) {
-		*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, "Invalid/missing param 'b'", NULL);
+	/* get parameters (all missing/invalid ones are reported at once) */
+	if (CJRPC2_RET_SUCCESS != cjrpc2_get_params(params, calc_params, &args, resp)) {
 		return CJRPC2_RET_ERROR;
 	}
 
 	/* calculate and "jsonify" result */
-	result = a + b;
+	result = args.a + args.b;
 	*resp = cJSON_CreateNumber(result);
 
 	return CJRPC2_RET_SUCCESS;
@@ -30,20 +39,16 @@ int impl_add(const cJSON *params, cJSON **resp)
 
 int impl_multiply(const cJSON *params, cJSON **resp)
 {
-	double a, b, result;
+	struct calc_args args;
+	double result;
 
-	/* get parameters */
-	if (PARAM_OK != cjrpc2_get_param_double(params, "a", &a)) {
-		*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, "Invalid/missing param 'a'", NULL);
-		return CJRPC2_RET_ERROR;
-	}
-	if (PARAM_OK != cjrpc2_get_param_double(params, "b", &b)) {
-		*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, "Invalid/missing param 'b'", NULL);
+	/* get parameters (all missing/invalid ones are reported at once) */
+	if (CJRPC2_RET_SUCCESS != cjrpc2_get_params(params, calc_params, &args, resp)) {
 		return CJRPC2_RET_ERROR;
 	}
 
 	/* calculate and "jsonify" result */
-	result = a * b;
+	result = args.a * args.b;
 	*resp = cJSON_CreateNumber(result);
 
 	return CJRPC2_RET_SUCCESS;
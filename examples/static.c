@@ -0,0 +1,76 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "cJRPC2.h"
+#include "static_table.h" /* generated from static_table.methods by cjrpc2_mph_gen */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int impl_get_version(const cJSON *params, cJSON **resp)
+{
+	(void)params; /* unused */
+
+	*resp = cJSON_CreateString(cjrpc2_version());
+
+	return CJRPC2_RET_SUCCESS;
+}
+
+int impl_echo(const cJSON *params, cJSON **resp)
+{
+	if (!params) {
+		*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, "Invalid params", NULL);
+		return CJRPC2_RET_ERROR;
+	}
+
+	*resp = cJSON_Duplicate(params, cJSON_True);
+	return CJRPC2_RET_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+	struct cjrpc2_handler handler, *h;
+	char *req, *ret;
+
+	(void)argc; /* unused */
+	(void)argv; /* unused */
+
+	printf("This program includes:\n");
+	printf("  cJRPC2, %s\n", CJRPC2_COPYRIGHT);
+	printf("  cJSON, Copyright (c) 2009-2017 Dave Gamble and cJSON contributors\n\n");
+
+	/* no allocation and no startup work, the method table was built at compile time */
+	h = cjrpc2_new_handler_static(&handler, &cjrpc2_table_static_table);
+	if (!h) {
+		fprintf(stderr, "Unable to create new cJRPC2 handler: %s\n", strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	req = cjrpc2_create_request_str("get-version", NULL, cJSON_CreateNumber(42));
+	ret = cjrpc2_handle_request(h, req);
+	free(req);
+	if (!ret) {
+		fprintf(stderr, "Unable to handle cJRPC2 request: %s\n", strerror(errno));
+		cjrpc2_free_handler(h);
+		return EXIT_FAILURE;
+	}
+	printf("%s\n", ret);
+	free(ret);
+
+	req = cjrpc2_create_request_str("echo", cJSON_CreateString("foo"),
+					cJSON_CreateString("bar"));
+	ret = cjrpc2_handle_request(h, req);
+	free(req);
+	if (!ret) {
+		fprintf(stderr, "Unable to handle cJRPC2 request: %s\n", strerror(errno));
+		cjrpc2_free_handler(h);
+		return EXIT_FAILURE;
+	}
+	printf("%s\n", ret);
+	free(ret);
+
+	cjrpc2_free_handler(h);
+
+	return EXIT_SUCCESS;
+}
@@ -3,6 +3,8 @@
 #define CJRPC2__H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "cJSON/cJSON.h"
 
@@ -27,18 +29,87 @@
 #define CJRPC2_RET_SUCCESS 0
 #define CJRPC2_RET_ERROR   1
 
+/* minimal free space returned by cjrpc2_stream_space() */
+#define CJRPC2_STREAM_CHUNK_SIZE 4096
+
+/* handler flags */
+#define CJRPC2_FLAG_LAZY_PARAMS (1u << 0) /**< parse params only when a method reads them */
+#define CJRPC2_FLAG_ARENA	(1u << 1) /**< allocate request and response trees from an arena */
+#define CJRPC2_FLAG_ERROR_OFFSET (1u << 2) /**< add the offset of parse errors as error data */
+#define CJRPC2_FLAG_TAPE	(1u << 3) /**< parse requests into a cJSON_Tape instead of a tree */
+
 struct cjrpc2_method {
 	const char *name;
 	int (*func)(const cJSON *params, cJSON **resp);
 };
 
+/** method table entry, everything needed for dispatch is stored inline */
 struct cjrpc2_method_entry {
-	struct cjrpc2_method *method;
-	struct cjrpc2_method_entry *next;
+	uint32_t hash;	  /**< hash of the method name */
+	uint32_t len;	  /**< length of the method name */
+	const char *name; /**< method name (NULL for an empty slot) */
+	int (*func)(const cJSON *params, cJSON **resp);
+};
+
+/**
+ * minimal perfect hash method table as generated by tools/cjrpc2-mphgen.py
+ * (see cjrpc2_new_handler_static())
+ */
+struct cjrpc2_static_table {
+	const struct cjrpc2_method_entry *entries; /**< one entry per method, no empty slots */
+	uint32_t size;				   /**< number of entries */
+	const uint32_t *displacements;		   /**< displacement per hash bucket */
+	uint32_t bucket_mask;			   /**< number of hash buckets minus one */
+	uint32_t wildcards;			   /**< number of "*" and "<namespace>.*" methods */
+};
+
+/** cjrpc2_method array mounted under a namespace (see cjrpc2_new_handler_mounts()) */
+struct cjrpc2_mount {
+	const char *prefix;	       /**< methods are registered as "<prefix>.<name>" (may be NULL) */
+	struct cjrpc2_method *methods; /**< NULL terminated array of methods */
+};
+
+/** open addressing (linear probing) method table */
+struct cjrpc2_mtable {
+	size_t mask;				    /**< number of slots minus one */
+	size_t count;				    /**< number of methods */
+	size_t wildcards;			    /**< number of wildcard methods */
+	struct cjrpc2_method_entry entries[]; /**< mask + 1 slots */
+};
+
+/** request arena chunk (see CJRPC2_FLAG_ARENA) */
+struct cjrpc2_arena {
+	struct cjrpc2_arena *next; /**< previous, full chunk */
+	size_t size;		   /**< usable bytes following the chunk header */
+	size_t used;		   /**< bytes handed out */
+};
+
+/** incremental reader splitting a byte stream (e.g. a socket) into requests */
+struct cjrpc2_stream {
+	char *buf;		/**< received bytes, a complete request starts at buf[0] */
+	size_t size;		/**< allocated size of buf */
+	size_t len;		/**< bytes received */
+	size_t scanned;		/**< bytes already scanned for the end of the request */
+	size_t end;		/**< length of the complete request (0 while incomplete) */
+	size_t max_len;		/**< maximum length of a pending request (0: no limit) */
+	unsigned int depth;	/**< nesting depth of the request at scanned */
+	unsigned char state;	/**< scanner state at scanned */
+	bool broken;		/**< request boundaries were lost on malformed input */
 };
 
 struct cjrpc2_handler {
-	struct cjrpc2_method_entry *mlist_head;
+	struct cjrpc2_mtable *mtable;		  /**< current method table snapshot (RCU) */
+	struct cjrpc2_mtable *mtable_embedded;	  /**< initial snapshot allocated with the handler */
+	const struct cjrpc2_static_table *stable; /**< perfect hash method table (or NULL) */
+	long epoch;				  /**< grace period counter of the method table */
+	long readers[2];			  /**< lookups in progress per epoch parity */
+	long writer;				  /**< method table writer lock */
+	struct cjrpc2_arena *arena;		  /**< request arena, kept across requests */
+	long arena_busy;			  /**< arena owned by a request in progress */
+	cJSON_ThreadHooks hooks;		  /**< allocator for requests (NULL: cJSON's global) */
+	cJSON_Limits limits;			  /**< what requests may contain (zero: no limit) */
+	unsigned int flags;			  /**< CJRPC2_FLAG_* (zero on creation) */
+	bool is_static;				  /**< handler memory is owned by the caller */
 };
 
 enum cjrpc2_param_status {
@@ -47,7 +118,42 @@ enum cjrpc2_param_status {
 	PARAM_WRONG_TYPE, /**< parameter was present but had a wrong type */
 	PARAM_NUM_NOINT,  /**< parameter value is a number, but not an integer as requested */
 	PARAM_OO_RANGE,	  /**< parameter was present but value was out of range */
-	PARAM_NOMEM	  /**< failed to allocate memory for the parameter value */
+	PARAM_NOMEM,	  /**< failed to allocate memory for the parameter value */
+	PARAM_EPARSE	  /**< params are not valid JSON (lazy params only) */
+};
+
+/** precomputed case sensitive parameter name (see cjrpc2_param_key()) */
+struct cjrpc2_param_key {
+	const char *name; /**< parameter name (need not be NULL terminated) */
+	size_t len;	  /**< length of name */
+	uint32_t hash;	  /**< FNV-1a hash of the len bytes of name */
+};
+
+/** C type of a parameter described by struct cjrpc2_param_desc */
+enum cjrpc2_param_type {
+	CJRPC2_PARAM_DOUBLE, /**< double */
+	CJRPC2_PARAM_INT,    /**< int */
+	CJRPC2_PARAM_INT64,  /**< int64_t */
+	CJRPC2_PARAM_UINT64, /**< uint64_t */
+	CJRPC2_PARAM_BOOL,   /**< bool */
+	CJRPC2_PARAM_STRING  /**< char * (allocated, freeing must be done by the caller) */
+};
+
+/* parameter descriptor flags */
+#define CJRPC2_PARAM_OPTIONAL (1u << 0) /**< a missing parameter leaves its value untouched */
+#define CJRPC2_PARAM_RANGE    (1u << 1) /**< numbers must be within min and max */
+
+/* maximal number of entries of a parameter descriptor table */
+#define CJRPC2_PARAM_DESC_MAX 64
+
+/** parameter of a cjrpc2_get_params() table, tables end with an entry without a name */
+struct cjrpc2_param_desc {
+	const char *name;	     /**< parameter name (case insensitive like cjrpc2_get_param_*()) */
+	enum cjrpc2_param_type type; /**< C type of the value */
+	size_t offset;		     /**< offset of the value in the struct to fill (see offsetof()) */
+	unsigned int flags;	     /**< CJRPC2_PARAM_* */
+	double min;		     /**< minimal number with CJRPC2_PARAM_RANGE */
+	double max;		     /**< maximal number with CJRPC2_PARAM_RANGE */
 };
 
 /**
@@ -78,24 +184,261 @@ struct cjrpc2_handler *cjrpc2_new_handler(struct cjrpc2_method *methods);
  */
 struct cjrpc2_handler *cjrpc2_new_handler_m(size_t count, ...);
 
+/**
+ * @fn
+ * @brief create a new cJRPC2 handler with cjrpc2_method arrays mounted under namespaces
+ *
+ * Methods named "*" or "<namespace>.*" are wildcards: they handle every request that has no exact
+ * match, the wildcard with the longest matching namespace wins.
+ *
+ * @param mounts array of mounts terminated by an entry with methods set to NULL
+ * @retval new handler instance on success
+ * @retval NULL on error
+ * @retval errno EINVAL or ENOMEN on error
+ */
+struct cjrpc2_handler *cjrpc2_new_handler_mounts(const struct cjrpc2_mount *mounts);
+
+/**
+ * @fn
+ * @brief initialize a cJRPC2 handler dispatching through a build time generated perfect hash table
+ * (see tools/cjrpc2-mphgen.py and the cjrpc2_mph_gen meson generator)
+ * @param h handler memory to initialize (allocation & freeing must be done by the caller)
+ * @param table generated method table
+ * @retval h on success
+ * @retval NULL on error
+ * @retval errno EINVAL on error
+ */
+struct cjrpc2_handler *cjrpc2_new_handler_static(struct cjrpc2_handler *h,
+						 const struct cjrpc2_static_table *table);
+
 /**
  * @fn
  * @brief free a existing cJRPC2 handler
- * @param h handler to free
+ * @param h handler to free (handlers from cjrpc2_new_handler_static() are only released, their
+ * memory stays owned by the caller)
  */
 void cjrpc2_free_handler(struct cjrpc2_handler *h);
 
+/**
+ * @fn
+ * @brief register a method at runtime
+ *
+ * May be called while other threads are handling requests with h: lookups never block, they see
+ * either the method table before or after the change. Concurrent calls to
+ * cjrpc2_register_method() and cjrpc2_unregister_method() are serialized.
+ *
+ * @param h handler to register the method at
+ * @param name method name (not copied, must stay valid until it is unregistered or h is freed)
+ * @param func method implementation
+ * @retval 0 on success
+ * @retval -1 on error
+ * @retval errno EINVAL, EEXIST or ENOMEM on error
+ */
+int cjrpc2_register_method(struct cjrpc2_handler *h, const char *name,
+			   int (*func)(const cJSON *params, cJSON **resp));
+
+/**
+ * @fn
+ * @brief unregister a method at runtime (see cjrpc2_register_method() for thread safety)
+ * @param h handler to unregister the method from
+ * @param name method name
+ * @retval 0 on success (no request started afterwards is dispatched to the method)
+ * @retval -1 on error
+ * @retval errno EINVAL, ENOENT, EPERM (method of a static table) or ENOMEM on error
+ */
+int cjrpc2_unregister_method(struct cjrpc2_handler *h, const char *name);
+
 /**
  * @fn
  * @brief handle an incoming JSONRPC2.0 request
+ *
+ * With CJRPC2_FLAG_ARENA set on the handler, all cJSON memory of a request (the parsed request and
+ * the response built by the method) is bump allocated from an arena of the handler, which is
+ * released at once when the response was printed and reused by the next request. Methods must
+ * therefore neither keep cJSON items beyond their return nor put items created outside of the
+ * request into their response. Concurrent requests on the same handler use regular allocations
+ * while the arena is busy.
+ *
+ * The hooks of the handler, if set, are used for all cJSON memory of its requests instead of the
+ * cJSON hooks of the calling thread, and for the arena and the response string. Every handler
+ * (e.g. one per thread) may thus use its own allocator. A handler without hooks leaves the hooks of
+ * the calling thread (cJSON_InitThreadHooks(), else cJSON_InitHooks()) in charge, they are in
+ * effect again after the request either way. Memory not owned by the arena is passed to the
+ * free_fn hook of the handler, or else of the calling thread.
+ *
+ * The limits of the handler, if set, apply to everything parsed while its requests are handled
+ * (see cJSON_InitThreadLimits()) in place of the limits of the calling thread, which are in
+ * effect again after the request. Requests longer than limits.max_length are refused right away,
+ * parsing stops at the first nesting level, member, element or string in excess. Either way the
+ * response is a JSONRPC2_EIREQ error with a null id, so the time and memory spent on a request
+ * stay bounded by the limits whatever it contains. With CJRPC2_FLAG_LAZY_PARAMS, params are only
+ * checked once a method reads them (their depth counted from params on), and members of the
+ * request other than "jsonrpc", "method", "params" and "id" are skipped unparsed.
+ *
+ * With CJRPC2_FLAG_TAPE set on the handler, requests are parsed into a cJSON_Tape, a flat array of
+ * 64 bit entries with a single string buffer, instead of a tree of cJSON items. The params passed
+ * to a method are then a placeholder (like with CJRPC2_FLAG_LAZY_PARAMS, which is ignored) that
+ * the cjrpc2_get_param_*() functions read straight from the tape, cjrpc2_params() converts them to
+ * a tree for other cJSON functions.
+ *
  * @param h handler to use
  * @param req request string
+ * @retval JSONRPC2.0 response string on success (must be free()' by the caller, or released with
+ *	   the free_fn hook of the handler, else with the cJSON hooks of the calling thread)
+ * @retval emtpy string on notification request (must be free()' by the caller like a response)
+ * @retval NULL on error
+ * @retval errno EINVAL or ENOMEM on error
+ */
+char *cjrpc2_handle_request(struct cjrpc2_handler *h, const char *req);
+
+/**
+ * @fn
+ * @brief handle an incoming JSONRPC2.0 request of a given length
+ * @param h handler to use
+ * @param req request buffer (no NULL termination required, never read beyond len)
+ * @param len length of the request in bytes
  * @retval JSONRPC2.0 response string on success (must be free()' by the caller)
  * @retval emtpy string on notification request (must be free()' by the caller)
  * @retval NULL on error
  * @retval errno EINVAL or ENOMEM on error
  */
-char *cjrpc2_handle_request(struct cjrpc2_handler *h, const char *req);
+char *cjrpc2_handle_request_len(struct cjrpc2_handler *h, const char *req, size_t len);
+
+/**
+ * @fn
+ * @brief handle an incoming JSONRPC2.0 request in a writable buffer
+ *
+ * Like cjrpc2_handle_request_len(), but strings of the request are decoded within req instead of
+ * being copied (see cJSON_ParseInSitu()). The content of req is undefined afterwards. Strings of
+ * the params point into req, so methods must not keep references to them beyond their return.
+ *
+ * @param h handler to use
+ * @param req request buffer (no NULL termination required, never accessed beyond len)
+ * @param len length of the request in bytes
+ * @retval JSONRPC2.0 response string on success (must be free()' by the caller)
+ * @retval emtpy string on notification request (must be free()' by the caller)
+ * @retval NULL on error
+ * @retval errno EINVAL or ENOMEM on error
+ */
+char *cjrpc2_handle_request_insitu(struct cjrpc2_handler *h, char *req, size_t len);
+
+/**
+ * @fn
+ * @brief initialize an empty request stream
+ *
+ * A stream takes the bytes of a connection in chunks as they arrive and scans them for the end of
+ * the request right away, keeping its state between chunks. Once a request is complete it is
+ * handled in place by cjrpc2_stream_handle() without copying it to another buffer. Requests must
+ * be JSON objects or arrays and may follow each other without separators.
+ *
+ * The buffer of the stream grows with the pending request, set max_len after initializing the
+ * stream to bound it (e.g. to limits.max_length of the handler). Once a pending request exceeds
+ * it, the stream fails with EMSGSIZE and the connection should be closed.
+ *
+ * @param s stream to initialize
+ */
+void cjrpc2_stream_init(struct cjrpc2_stream *s);
+
+/**
+ * @fn
+ * @brief free the buffer of a stream (the stream may be initialized again afterwards)
+ * @param s stream to free
+ */
+void cjrpc2_stream_free(struct cjrpc2_stream *s);
+
+/**
+ * @fn
+ * @brief get free space at the end of the stream buffer to receive into directly
+ * @param s stream to receive into
+ * @param size pointer to store the free size at (at least CJRPC2_STREAM_CHUNK_SIZE)
+ * @retval pointer to the free space, valid until the next call on the stream
+ * @retval NULL on error
+ * @retval errno ENOMEM on error
+ */
+char *cjrpc2_stream_space(struct cjrpc2_stream *s, size_t *size);
+
+/**
+ * @fn
+ * @brief add bytes received into the space of cjrpc2_stream_space() to the stream
+ * @param s stream received into
+ * @param len number of bytes received (at most the free size)
+ * @retval 1 if a complete request is ready for cjrpc2_stream_handle()
+ * @retval 0 if more bytes are needed
+ * @retval -1 on error
+ * @retval errno EINVAL, EMSGSIZE (request longer than max_len) or EPROTO (malformed input, see
+ *	   cjrpc2_stream_handle()) on error
+ */
+int cjrpc2_stream_commit(struct cjrpc2_stream *s, size_t len);
+
+/**
+ * @fn
+ * @brief copy a received chunk to the stream (cjrpc2_stream_space() and cjrpc2_stream_commit())
+ * @param s stream to feed
+ * @param data received bytes
+ * @param len number of received bytes
+ * @retval 1 if a complete request is ready for cjrpc2_stream_handle()
+ * @retval 0 if more bytes are needed
+ * @retval -1 on error
+ * @retval errno EINVAL, ENOMEM, EMSGSIZE or EPROTO on error
+ */
+int cjrpc2_stream_feed(struct cjrpc2_stream *s, const char *data, size_t len);
+
+/**
+ * @fn
+ * @brief handle the complete request at the start of the stream and drop it from the stream
+ *
+ * The request is parsed in place like with cjrpc2_handle_request_insitu(). Bytes following it are
+ * scanned for the next request, so this function may be called again until it fails with EAGAIN.
+ * A request that can't be a JSON object or array is answered with a parse error, as the end of it
+ * can't be told, the stream fails with EPROTO afterwards and the connection should be closed.
+ *
+ * @param h handler to use
+ * @param s stream to take the request from
+ * @retval JSONRPC2.0 response string on success (must be free()' by the caller)
+ * @retval emtpy string on notification request (must be free()' by the caller)
+ * @retval NULL on error
+ * @retval errno EAGAIN (no complete request), EPROTO, EINVAL or ENOMEM on error
+ */
+char *cjrpc2_stream_handle(struct cjrpc2_handler *h, struct cjrpc2_stream *s);
+
+/**
+ * @fn
+ * @brief get the params of a request as cJSON tree
+ *
+ * With CJRPC2_FLAG_LAZY_PARAMS set on the handler, only the top level "jsonrpc", "method" and "id"
+ * members of a request are parsed before dispatching. The params passed to a method are then just
+ * a placeholder which is parsed on the first access by the cjrpc2_get_param_*() functions or this
+ * function, it must not be used with other cJSON functions directly. Invalid params are reported
+ * as PARAM_EPARSE to the method and answered with a parse error instead of the method's response.
+ * Params that are never read are never validated.
+ *
+ * With CJRPC2_FLAG_TAPE set on the handler, this function converts the params placeholder to a
+ * tree on the first call.
+ *
+ * @param params params as passed to a method
+ * @retval params tree (valid until the method returns)
+ * @retval NULL on missing or invalid params
+ * @retval errno EINVAL on invalid params, ENOMEM if the tape could not be converted
+ */
+const cJSON *cjrpc2_params(const cJSON *params);
+
+/**
+ * @fn
+ * @brief get a cursor stepping through the params of a request token by token
+ *
+ * With CJRPC2_FLAG_LAZY_PARAMS set on the handler (and CJRPC2_FLAG_TAPE not set), a method can
+ * read its params with cJSON_CursorNext() straight from the request instead of having them parsed
+ * into a tree, e.g. to process long arrays in constant memory. Every call starts over at the
+ * beginning of the params. Invalid params the cursor runs into are answered with a parse error
+ * like with cjrpc2_params().
+ *
+ * @param params params as passed to a method
+ * @retval cursor (valid until the method returns, released by the handler)
+ * @retval NULL on missing params, without lazy params or if the params of a request handled in
+ *	   situ were already parsed by cjrpc2_params()
+ * @retval errno EINVAL on error
+ */
+cJSON_Cursor *cjrpc2_params_cursor(const cJSON *params);
 
 /**
  * @fn
@@ -187,6 +530,32 @@ enum cjrpc2_param_status cjrpc2_get_param_int(const cJSON *params, const char *n
 enum cjrpc2_param_status cjrpc2_get_param_int_range(const cJSON *params, const char *name,
 						    int *value, const int min, const int max);
 
+/**
+ * @fn
+ * @brief get a 64 bit integer parameter by its name from an cJRPC2 params list (integer literals
+ * are kept exactly, also beyond 2^53)
+ * @param params parameter list
+ * @param name parameter to get
+ * @param value pointer to store the integer value at (allocation & freeing must be done by the
+ * caller)
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_int64(const cJSON *params, const char *name,
+						int64_t *value);
+
+/**
+ * @fn
+ * @brief get an unsigned 64 bit integer parameter by its name from an cJRPC2 params list (integer
+ * literals are kept exactly, also beyond 2^53)
+ * @param params parameter list
+ * @param name parameter to get
+ * @param value pointer to store the integer value at (allocation & freeing must be done by the
+ * caller)
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_uint64(const cJSON *params, const char *name,
+						 uint64_t *value);
+
 /**
  * @fn
  * @brief get an boolean parameter by its name from an cJRPC2 params list
@@ -209,4 +578,234 @@ enum cjrpc2_param_status cjrpc2_get_param_bool(const cJSON *params, const char *
 enum cjrpc2_param_status cjrpc2_get_param_string(const cJSON *params, const char *name,
 						 char **value);
 
+
+/**
+ * @fn
+ * @brief precompute the case sensitive key of a parameter name for the cjrpc2_get_param_*_key()
+ * functions (e.g. once in a static initializer or at startup)
+ * @param name NULL terminated parameter name (must stay valid as long as the key is used)
+ * @retval key of name
+ */
+struct cjrpc2_param_key cjrpc2_param_key(const char *name);
+
+/**
+ * @fn
+ * @brief cjrpc2_get_param_double() with a case sensitive key, members of indexed (large) params
+ * whose length or hash don't match are rejected without comparing their names
+ * @param params parameter list
+ * @param key parameter to get
+ * @param value pointer to store the double value at
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_double_key(const cJSON *params,
+						     const struct cjrpc2_param_key *key,
+						     double *value);
+
+/**
+ * @fn
+ * @brief cjrpc2_get_param_double_range() with a case sensitive key
+ * @param params parameter list
+ * @param key parameter to get
+ * @param value pointer to store the double value at
+ * @param min minimal allowed value
+ * @param max maximal allowed value
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_double_range_key(const cJSON *params,
+							   const struct cjrpc2_param_key *key,
+							   double *value, const double min,
+							   const double max);
+
+/**
+ * @fn
+ * @brief cjrpc2_get_param_int() with a case sensitive key
+ * @param params parameter list
+ * @param key parameter to get
+ * @param value pointer to store the integer value at
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_int_key(const cJSON *params,
+						  const struct cjrpc2_param_key *key, int *value);
+
+/**
+ * @fn
+ * @brief cjrpc2_get_param_int_range() with a case sensitive key
+ * @param params parameter list
+ * @param key parameter to get
+ * @param value pointer to store the integer value at
+ * @param min minimal allowed value
+ * @param max maximal allowed value
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_int_range_key(const cJSON *params,
+							const struct cjrpc2_param_key *key,
+							int *value, const int min, const int max);
+
+/**
+ * @fn
+ * @brief cjrpc2_get_param_int64() with a case sensitive key
+ * @param params parameter list
+ * @param key parameter to get
+ * @param value pointer to store the integer value at
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_int64_key(const cJSON *params,
+						    const struct cjrpc2_param_key *key,
+						    int64_t *value);
+
+/**
+ * @fn
+ * @brief cjrpc2_get_param_uint64() with a case sensitive key
+ * @param params parameter list
+ * @param key parameter to get
+ * @param value pointer to store the integer value at
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_uint64_key(const cJSON *params,
+						     const struct cjrpc2_param_key *key,
+						     uint64_t *value);
+
+/**
+ * @fn
+ * @brief cjrpc2_get_param_bool() with a case sensitive key
+ * @param params parameter list
+ * @param key parameter to get
+ * @param value pointer to store the bool value at
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_bool_key(const cJSON *params,
+						   const struct cjrpc2_param_key *key, bool *value);
+
+/**
+ * @fn
+ * @brief cjrpc2_get_param_string() with a case sensitive key
+ * @param params parameter list
+ * @param key parameter to get
+ * @param value pointer to store the NULL terminated char array at (allocated by the function,
+ * freeing must be done by the caller)
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_string_key(const cJSON *params,
+						     const struct cjrpc2_param_key *key,
+						     char **value);
+
+/**
+ * @fn
+ * @brief get a double parameter by its position from positional params (an array)
+ *
+ * The elements of long params passed to a method are indexed on the first access within the
+ * request, so that reading every parameter takes linear time. The index is released with the
+ * request. Arrays the method builds itself are walked instead.
+ *
+ * @param params parameter list
+ * @param position position of the parameter (starting at 0)
+ * @param value pointer to store the double value at
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_double_at(const cJSON *params, size_t position,
+						    double *value);
+
+/**
+ * @fn
+ * @brief cjrpc2_get_param_double_range() by position (see cjrpc2_get_param_double_at())
+ * @param params parameter list
+ * @param position position of the parameter (starting at 0)
+ * @param value pointer to store the double value at
+ * @param min minimal allowed value
+ * @param max maximal allowed value
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_double_range_at(const cJSON *params, size_t position,
+							  double *value, const double min,
+							  const double max);
+
+/**
+ * @fn
+ * @brief cjrpc2_get_param_int() by position (see cjrpc2_get_param_double_at())
+ * @param params parameter list
+ * @param position position of the parameter (starting at 0)
+ * @param value pointer to store the int value at
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_int_at(const cJSON *params, size_t position, int *value);
+
+/**
+ * @fn
+ * @brief cjrpc2_get_param_int_range() by position (see cjrpc2_get_param_double_at())
+ * @param params parameter list
+ * @param position position of the parameter (starting at 0)
+ * @param value pointer to store the int value at
+ * @param min minimal allowed value
+ * @param max maximal allowed value
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_int_range_at(const cJSON *params, size_t position,
+						       int *value, const int min, const int max);
+
+/**
+ * @fn
+ * @brief cjrpc2_get_param_int64() by position (see cjrpc2_get_param_double_at())
+ * @param params parameter list
+ * @param position position of the parameter (starting at 0)
+ * @param value pointer to store the int64_t value at
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_int64_at(const cJSON *params, size_t position,
+						   int64_t *value);
+
+/**
+ * @fn
+ * @brief cjrpc2_get_param_uint64() by position (see cjrpc2_get_param_double_at())
+ * @param params parameter list
+ * @param position position of the parameter (starting at 0)
+ * @param value pointer to store the uint64_t value at
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_uint64_at(const cJSON *params, size_t position,
+						    uint64_t *value);
+
+/**
+ * @fn
+ * @brief cjrpc2_get_param_bool() by position (see cjrpc2_get_param_double_at())
+ * @param params parameter list
+ * @param position position of the parameter (starting at 0)
+ * @param value pointer to store the bool value at
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_bool_at(const cJSON *params, size_t position,
+						  bool *value);
+
+/**
+ * @fn
+ * @brief cjrpc2_get_param_string() by position (see cjrpc2_get_param_double_at())
+ * @param params parameter list
+ * @param position position of the parameter (starting at 0)
+ * @param value pointer to store the NULL terminated char array at (allocated by the function,
+ * freeing must be done by the caller)
+ * @retval cjrpc2_param_status
+ */
+enum cjrpc2_param_status cjrpc2_get_param_string_at(const cJSON *params, size_t position,
+						    char **value);
+
+/**
+ * @fn
+ * @brief fill a struct with all parameters of a descriptor table at once
+ *
+ * The members of params are read in a single pass instead of one lookup per parameter. Positional
+ * params (an array) fill the table entries in order instead. Values are converted like by the
+ * cjrpc2_get_param_*() function of their type. If any parameter is missing
+ * or invalid, nothing is left allocated and resp is set to one JSONRPC2_EIPARAM error response
+ * whose data maps the name of every failed parameter to the reason (e.g. "missing" or "out of
+ * range"), so that a method can just return CJRPC2_RET_ERROR.
+ *
+ * @param params parameter list
+ * @param desc table of at most CJRPC2_PARAM_DESC_MAX parameters
+ * @param base struct to store the values at
+ * @param resp pointer to store the error response at
+ * @retval CJRPC2_RET_SUCCESS if all parameters were stored
+ * @retval CJRPC2_RET_ERROR otherwise
+ */
+int cjrpc2_get_params(const cJSON *params, const struct cjrpc2_param_desc *desc, void *base,
+		      cJSON **resp);
+
 #endif
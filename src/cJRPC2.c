@@ -3,6 +3,7 @@
 #include "cJRPC2.h"
 #include "cJSON/cJSON.h"
 
+#include <ctype.h>
 #include <errno.h>
 #include <limits.h>
 #include <math.h>
@@ -16,6 +17,167 @@
 	#error cJRPC2.h and cJRPC2.c have different versions. Make sure that both have the same.
 #endif
 
+/* minimal number of slots in a handler's method table (must be a power of two) */
+#define CJRPC2_MTABLE_MIN_SLOTS 8
+
+/* atomics for the method table RCU (all sequentially consistent) */
+#if defined(__GNUC__) || defined(__clang__)
+	#define cjrpc2_atomic_load(p)	      __atomic_load_n((p), __ATOMIC_SEQ_CST)
+	#define cjrpc2_atomic_store(p, v)     __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+	#define cjrpc2_atomic_load_ptr(p)     __atomic_load_n((p), __ATOMIC_SEQ_CST)
+	#define cjrpc2_atomic_store_ptr(p, v) __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+	#define cjrpc2_atomic_inc(p)	      ((void)__atomic_add_fetch((p), 1, __ATOMIC_SEQ_CST))
+	#define cjrpc2_atomic_dec(p)	      ((void)__atomic_sub_fetch((p), 1, __ATOMIC_SEQ_CST))
+	#define cjrpc2_atomic_cas(p, o, n)    __sync_bool_compare_and_swap((p), (o), (n))
+	#if defined(__x86_64__) || defined(__i386__)
+		#define cjrpc2_cpu_relax() __builtin_ia32_pause()
+	#else
+		#define cjrpc2_cpu_relax() ((void)0)
+	#endif
+#elif defined(_MSC_VER)
+	#include <intrin.h>
+	/* interlocked functions are full barriers */
+	#define cjrpc2_atomic_load(p)	  _InterlockedOr((volatile long *)(p), 0)
+	#define cjrpc2_atomic_store(p, v) ((void)_InterlockedExchange((volatile long *)(p), (v)))
+	#define cjrpc2_atomic_load_ptr(p)                                                          \
+		_InterlockedCompareExchangePointer((void *volatile *)(p), NULL, NULL)
+	#define cjrpc2_atomic_store_ptr(p, v)                                                      \
+		((void)_InterlockedExchangePointer((void *volatile *)(p), (v)))
+	#define cjrpc2_atomic_inc(p) ((void)_InterlockedIncrement((volatile long *)(p)))
+	#define cjrpc2_atomic_dec(p) ((void)_InterlockedDecrement((volatile long *)(p)))
+	#define cjrpc2_atomic_cas(p, o, n)                                                         \
+		(_InterlockedCompareExchange((volatile long *)(p), (n), (o)) == (o))
+	#define cjrpc2_cpu_relax() _mm_pause()
+#else
+	/* no atomics available, runtime method (un)registration is not thread safe */
+	#define cjrpc2_atomic_load(p)	      (*(p))
+	#define cjrpc2_atomic_store(p, v)     ((void)(*(p) = (v)))
+	#define cjrpc2_atomic_load_ptr(p)     (*(p))
+	#define cjrpc2_atomic_store_ptr(p, v) ((void)(*(p) = (v)))
+	#define cjrpc2_atomic_inc(p)	      ((void)++(*(p)))
+	#define cjrpc2_atomic_dec(p)	      ((void)--(*(p)))
+	#define cjrpc2_atomic_cas(p, o, n)    (*(p) == (o) ? (*(p) = (n), true) : false)
+	#define cjrpc2_cpu_relax()	      ((void)0)
+#endif
+
+/* thread local storage for the arena of the request in progress */
+#if defined(__GNUC__) || defined(__clang__)
+	#define CJRPC2_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+	#define CJRPC2_THREAD_LOCAL __declspec(thread)
+#else
+	/* no thread local storage, requests on arena handlers must not run concurrently */
+	#define CJRPC2_THREAD_LOCAL
+#endif
+
+/* size of a handler's first arena chunk and alignment of arena allocations */
+#define CJRPC2_ARENA_CHUNK_SIZE 4096
+#define CJRPC2_ARENA_ALIGN	16
+/* arenas grown beyond this size by a request are not kept for the next one */
+#define CJRPC2_ARENA_KEEP_MAX (1024 * 1024)
+/* size of struct cjrpc2_arena rounded up to the alignment, data follows the header */
+#define CJRPC2_ARENA_HDR_SIZE                                                                      \
+	((sizeof(struct cjrpc2_arena) + CJRPC2_ARENA_ALIGN - 1) & ~(size_t)(CJRPC2_ARENA_ALIGN - 1))
+
+typedef int (*cjrpc2_func)(const cJSON *params, cJSON **resp);
+
+/* private cJSON type flag of the params item passed to methods in lazy mode */
+#define CJRPC2_TYPE_LAZY (1 << 14)
+
+/* private cJSON type flag of the params item passed to methods in tape mode */
+#define CJRPC2_TYPE_TAPE (1 << 15)
+
+/* method names up to this size are decoded on the stack in lazy mode */
+#define CJRPC2_LAZY_METHOD_SIZE 128
+
+/* scanner states of struct cjrpc2_stream */
+enum cjrpc2_stream_state {
+	CJRPC2_STREAM_VALUE,  /* before the request */
+	CJRPC2_STREAM_STRUCT, /* within the request, outside of strings */
+	CJRPC2_STREAM_STRING, /* within a string */
+	CJRPC2_STREAM_ESCAPE  /* after a backslash within a string */
+};
+
+/* objects with at least this many members are indexed on their first parameter lookup */
+#define CJRPC2_INDEX_MIN_MEMBERS 16
+
+/* slot of a member index, item is NULL for an empty slot */
+struct cjrpc2_index_slot {
+	uint32_t hash;
+	uint32_t len;
+	const char *name;
+	const void *item; /* cJSON member or tape entry of the member's value */
+};
+
+/*
+ * open addressing (linear probing) hash index over the members of an object, members are inserted
+ * in order so that the first one of equal names is found first
+ */
+struct cjrpc2_member_index {
+	struct cjrpc2_member_index *next; /* index of another object of the same request */
+	const void *object;		  /* cJSON object or its tape entry */
+	bool case_sensitive;
+	size_t mask;
+	struct cjrpc2_index_slot slots[];
+};
+
+/* positions of the elements of an array */
+struct cjrpc2_array_index {
+	struct cjrpc2_array_index *next; /* index of another array of the same request */
+	const void *array;		 /* cJSON array or its tape entry */
+	size_t count;
+	const void *items[]; /* cJSON element or tape entry per position */
+};
+
+/* request in progress on a thread */
+struct cjrpc2_request {
+	struct cjrpc2_handler *h;
+	struct cjrpc2_request *outer; /* request whose method issued this one (or NULL) */
+	const cJSON *params; /* passed to the method, a placeholder with lazy params or a tape */
+	struct cjrpc2_member_index *indexes;
+	struct cjrpc2_array_index *arrays;
+};
+
+/* part of the request buffer */
+struct cjrpc2_slice {
+	const char *ptr;
+	size_t len;
+};
+
+/* top level members of a request, ptr is NULL for missing members */
+struct cjrpc2_envelope {
+	struct cjrpc2_slice jsonrpc;
+	struct cjrpc2_slice method;
+	struct cjrpc2_slice params;
+	struct cjrpc2_slice id;
+	const char *error; /* where malformed input was found (or NULL) */
+};
+
+/* params in tape mode, converted to a tree on first access by cjrpc2_params() */
+struct cjrpc2_tape_params {
+	cJSON item; /* type CJRPC2_TYPE_TAPE, must be the first member */
+	const cJSON_Tape *tape;
+	size_t index; /* entry of the params value */
+	cJSON *tree;
+};
+
+/* params in lazy mode, parsed on first access by cjrpc2_params() */
+struct cjrpc2_lazy_params {
+	cJSON item; /* type CJRPC2_TYPE_LAZY, must be the first member */
+	const char *raw;
+	char *in_situ; /* writable alias of raw for cJSON_ParseInSitu(), NULL otherwise */
+	size_t len;
+	cJSON *tree;
+	size_t error; /* offset of the syntax error in raw if failed */
+	bool failed;
+	bool limit; /* failed at a limit of the handler rather than a syntax error */
+	cJSON_Cursor cursor; /* see cjrpc2_params_cursor() */
+};
+
+/* FNV-1a parameters used for method names (must match tools/cjrpc2-mphgen.py) */
+#define CJRPC2_FNV_BASIS 2166136261u
+#define CJRPC2_FNV_PRIME 16777619u
+
 static cJSON *cjrpc2_create_skeleton()
 {
 	cJSON *j_skel, *j_jsonrpc;
@@ -163,253 +325,2550 @@ const char *cjrpc2_version(void)
 	return version;
 }
 
-struct cjrpc2_handler *cjrpc2_new_handler(struct cjrpc2_method *methods)
+/* FNV-1a step */
+static uint32_t cjrpc2_hash_step(uint32_t hash, char c)
 {
-	return cjrpc2_new_handler_m(1, methods);
+	return (hash ^ (unsigned char)c) * CJRPC2_FNV_PRIME;
 }
 
-struct cjrpc2_handler *cjrpc2_new_handler_m(size_t count, ...)
+/* FNV-1a, also returns the length of name */
+static uint32_t cjrpc2_hash(const char *name, size_t *len)
+{
+	const char *c;
+	uint32_t hash = CJRPC2_FNV_BASIS;
+
+	for (c = name; *c; c++) {
+		hash = cjrpc2_hash_step(hash, *c);
+	}
+	*len = (size_t)(c - name);
+
+	return hash;
+}
+
+static bool cjrpc2_is_wildcard(const char *name, size_t len)
+{
+	return (len == 1 && name[0] == '*') ||
+	       (len > 1 && name[len - 2] == '.' && name[len - 1] == '*');
+}
+
+/* with wildcard set the entry has to match "<name>*" */
+static bool cjrpc2_mentry_match(const struct cjrpc2_method_entry *me, const char *name, size_t len,
+				uint32_t hash, bool wildcard)
+{
+	if (wildcard) {
+		return me->hash == hash && me->len == len + 1 && !memcmp(me->name, name, len) &&
+		       me->name[len] == '*';
+	}
+	return me->hash == hash && me->len == len && !memcmp(me->name, name, len);
+}
+
+static int cjrpc2_mtable_insert(struct cjrpc2_mtable *t, const char *name,
+				int (*func)(const cJSON *params, cJSON **resp))
 {
-	va_list ap;
-	struct cjrpc2_handler *h;
-	struct cjrpc2_method *methods;
 	struct cjrpc2_method_entry *me;
-	unsigned int i, j;
+	uint32_t hash;
+	size_t i, len;
 
-	if (!count) {
-		errno = EINVAL;
+	hash = cjrpc2_hash(name, &len);
+	if (len > UINT32_MAX || !func) {
+		return -EINVAL;
+	}
+	for (i = hash & t->mask;; i = (i + 1) & t->mask) {
+		me = &t->entries[i];
+		if (!me->name) {
+			me->hash = hash;
+			me->len = (uint32_t)len;
+			me->name = name;
+			me->func = func;
+			t->count++;
+			if (cjrpc2_is_wildcard(name, len)) {
+				t->wildcards++;
+			}
+			return 0;
+		}
+		if (cjrpc2_mentry_match(me, name, len, hash, false)) {
+			/* first registration wins */
+			return -EEXIST;
+		}
+	}
+}
+
+/* must match mix() in tools/cjrpc2-mphgen.py */
+static uint32_t cjrpc2_mph_mix(uint32_t hash)
+{
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35u;
+	hash ^= hash >> 16;
+
+	return hash;
+}
+
+static const struct cjrpc2_method_entry *cjrpc2_stable_find(const struct cjrpc2_static_table *st,
+							    const char *name, size_t len,
+							    uint32_t hash, bool wildcard)
+{
+	const struct cjrpc2_method_entry *me;
+
+	if (!st || !st->size) {
 		return NULL;
 	}
+	me = &st->entries[cjrpc2_mph_mix(hash ^ st->displacements[hash & st->bucket_mask]) %
+			  st->size];
 
-	h = (struct cjrpc2_handler *)malloc(sizeof(struct cjrpc2_handler));
-	if (!h) {
-		goto exit_free_enomem;
+	return cjrpc2_mentry_match(me, name, len, hash, wildcard) ? me : NULL;
+}
+
+static const struct cjrpc2_method_entry *cjrpc2_mtable_find(const struct cjrpc2_mtable *t,
+							    const char *name, size_t len,
+							    uint32_t hash, bool wildcard)
+{
+	const struct cjrpc2_method_entry *me;
+	size_t i;
+
+	if (!t) {
+		return NULL;
+	}
+	for (i = hash & t->mask;; i = (i + 1) & t->mask) {
+		me = &t->entries[i];
+		if (!me->name) {
+			return NULL;
+		}
+		if (cjrpc2_mentry_match(me, name, len, hash, wildcard)) {
+			return me;
+		}
 	}
+}
+
+/* static methods take precedence over runtime registered ones */
+static const struct cjrpc2_method_entry *cjrpc2_find(const struct cjrpc2_static_table *st,
+						     const struct cjrpc2_mtable *t,
+						     const char *name, size_t len, uint32_t hash,
+						     bool wildcard)
+{
+	const struct cjrpc2_method_entry *me;
 
-	h->mlist_head = (struct cjrpc2_method_entry *)malloc(sizeof(struct cjrpc2_method_entry));
-	if (!h->mlist_head) {
-		goto exit_free_enomem;
+	me = cjrpc2_stable_find(st, name, len, hash, wildcard);
+	if (!me) {
+		me = cjrpc2_mtable_find(t, name, len, hash, wildcard);
 	}
-	me = h->mlist_head;
-	me->method = NULL;
-	me->next = NULL;
 
-	va_start(ap, count);
-	for (j = 0; j < count; j++) {
-		methods = va_arg(ap, struct cjrpc2_method *);
-		if (!methods)
+	return me;
+}
+
+static const struct cjrpc2_method_entry *cjrpc2_lookup(const struct cjrpc2_static_table *st,
+						       const struct cjrpc2_mtable *t,
+						       const char *name)
+{
+	const struct cjrpc2_method_entry *me, *wme;
+	uint32_t hash;
+	size_t i, len;
+
+	hash = cjrpc2_hash(name, &len);
+	me = cjrpc2_find(st, t, name, len, hash, false);
+	if (me || !((st && st->wildcards) || (t && t->wildcards))) {
+		return me;
+	}
+
+	/*
+	 * namespace fallback: the most specific "<namespace>.*" (or "*") handler wins, the prefix
+	 * hashes are built up incrementally so this stays linear in the name length
+	 */
+	me = cjrpc2_find(st, t, name, 0, cjrpc2_hash_step(CJRPC2_FNV_BASIS, '*'), true);
+	hash = CJRPC2_FNV_BASIS;
+	for (i = 0; i < len; i++) {
+		hash = cjrpc2_hash_step(hash, name[i]);
+		if (name[i] != '.') {
 			continue;
+		}
+		wme = cjrpc2_find(st, t, name, i + 1, cjrpc2_hash_step(hash, '*'), true);
+		if (wme) {
+			me = wme;
+		}
+	}
 
-		for (i = 0; methods[i].name; i++) {
-			if (!me->method) {
-				/* populate first */
-				me->method = &methods[i];
-				me->next = NULL;
-				continue;
-			}
+	return me;
+}
 
-			me->next = (struct cjrpc2_method_entry *)malloc(
-				sizeof(struct cjrpc2_method_entry));
-			if (!h->mlist_head) {
-				goto exit_free_enomem;
-			}
-			me = me->next;
-			me->method = &methods[i];
-			me->next = NULL;
+/* read side of the method table RCU, never blocks */
+static cjrpc2_func cjrpc2_lookup_func(struct cjrpc2_handler *h, const char *name)
+{
+	const struct cjrpc2_method_entry *me;
+	cjrpc2_func func;
+	long *readers;
+
+	readers = &h->readers[cjrpc2_atomic_load(&h->epoch) & 1];
+	cjrpc2_atomic_inc(readers);
+	me = cjrpc2_lookup(h->stable, cjrpc2_atomic_load_ptr(&h->mtable), name);
+	func = me ? me->func : NULL;
+	cjrpc2_atomic_dec(readers);
+
+	return func;
+}
+
+/* wait until no reader can reference a method table replaced before this call */
+static void cjrpc2_synchronize(struct cjrpc2_handler *h)
+{
+	long epoch;
+	int i;
+
+	/*
+	 * readers might have sampled the epoch before the previous flip, so both reader counts
+	 * have to drain once
+	 */
+	for (i = 0; i < 2; i++) {
+		epoch = cjrpc2_atomic_load(&h->epoch);
+		cjrpc2_atomic_store(&h->epoch, epoch + 1);
+		while (cjrpc2_atomic_load(&h->readers[epoch & 1])) {
+			cjrpc2_cpu_relax();
 		}
 	}
-	va_end(ap);
+}
 
-	return h;
+static size_t cjrpc2_mtable_slots(size_t mcount)
+{
+	size_t slots;
 
-exit_free_enomem:
-	cjrpc2_free_handler(h);
-	errno = ENOMEM;
-	return NULL;
+	/* keep the load factor at or below 1/2 */
+	for (slots = CJRPC2_MTABLE_MIN_SLOTS; slots < mcount * 2; slots <<= 1)
+		;
+
+	return slots;
 }
 
-void cjrpc2_free_handler(struct cjrpc2_handler *h)
+static size_t cjrpc2_mtable_size(size_t mcount)
 {
-	struct cjrpc2_method_entry *me, *mef;
+	return sizeof(struct cjrpc2_mtable) +
+	       cjrpc2_mtable_slots(mcount) * sizeof(struct cjrpc2_method_entry);
+}
 
-	if (!h) {
-		return;
+static void cjrpc2_mtable_init(struct cjrpc2_mtable *t, size_t mcount)
+{
+	t->mask = cjrpc2_mtable_slots(mcount) - 1;
+	t->count = 0;
+	t->wildcards = 0;
+}
+
+/* copy of t with room for extra more methods, except entry skip */
+static struct cjrpc2_mtable *cjrpc2_mtable_copy(const struct cjrpc2_mtable *t, size_t extra,
+						const struct cjrpc2_method_entry *skip)
+{
+	struct cjrpc2_mtable *copy;
+	size_t mcount, i;
+
+	mcount = (t ? t->count : 0) + extra;
+	copy = (struct cjrpc2_mtable *)calloc(1, cjrpc2_mtable_size(mcount));
+	if (!copy) {
+		return NULL;
 	}
-	mef = h->mlist_head;
-	while (mef) {
-		me = mef->next;
-		free(mef);
-		mef = me;
+	cjrpc2_mtable_init(copy, mcount);
+
+	for (i = 0; t && i <= t->mask; i++) {
+		if (t->entries[i].name && &t->entries[i] != skip) {
+			cjrpc2_mtable_insert(copy, t->entries[i].name, t->entries[i].func);
+		}
 	}
-	free(h);
+
+	return copy;
 }
 
-char *cjrpc2_handle_request(struct cjrpc2_handler *h, const char *req)
+/* publish a new method table and release the old one once no reader uses it anymore */
+static void cjrpc2_mtable_replace(struct cjrpc2_handler *h, struct cjrpc2_mtable *t)
 {
-	struct cjrpc2_method_entry *me;
-	cJSON *j_req, *j_reqjsonrpc, *j_method, *j_params, *j_id;
-	cJSON *j_resp, *j_result;
-	char *ret;
+	struct cjrpc2_mtable *old;
 
-	if (!h) {
-		errno = EINVAL;
-		return NULL;
+	old = h->mtable;
+	cjrpc2_atomic_store_ptr(&h->mtable, t);
+	cjrpc2_synchronize(h);
+	if (old != h->mtable_embedded) {
+		free(old);
 	}
+}
 
-	/* parse and validate request */
-	j_req = cJSON_Parse(req);
-	if (!j_req) {
-		j_resp = cjrpc2_create_response_error(JSONRPC2_EPARSE, "parse error", NULL, NULL);
-		goto exit_ret;
+static void cjrpc2_writer_lock(struct cjrpc2_handler *h)
+{
+	while (!cjrpc2_atomic_cas(&h->writer, 0, 1)) {
+		cjrpc2_cpu_relax();
 	}
+}
 
-	j_reqjsonrpc = cJSON_GetObjectItem(j_req, "jsonrpc");
-	j_method = cJSON_GetObjectItem(j_req, "method");
-	if (!j_reqjsonrpc || !cJSON_IsString(j_reqjsonrpc) ||
-	    strcmp(j_reqjsonrpc->valuestring, JSONRPC2_VERSION) || !j_method ||
-	    !cJSON_IsString(j_method) || !j_method->valuestring) {
-		j_resp =
-			cjrpc2_create_response_error(JSONRPC2_EIREQ, "invalid request", NULL, NULL);
-		goto exit_ret;
+static void cjrpc2_writer_unlock(struct cjrpc2_handler *h)
+{
+	cjrpc2_atomic_store(&h->writer, 0);
+}
+
+/* innermost request in progress on this thread and the handler whose arena it uses (if any) */
+static CJRPC2_THREAD_LOCAL struct cjrpc2_request *cjrpc2_current;
+static CJRPC2_THREAD_LOCAL struct cjrpc2_handler *cjrpc2_arena_owner;
+/*
+ * cJSON thread hooks and limits of the application, saved by the outermost request and restored
+ * after it
+ */
+static CJRPC2_THREAD_LOCAL cJSON_ThreadHooks cjrpc2_caller_hooks;
+static CJRPC2_THREAD_LOCAL bool cjrpc2_caller_has_hooks;
+static CJRPC2_THREAD_LOCAL cJSON_Limits cjrpc2_caller_limits;
+
+static void *cjrpc2_malloc(const struct cjrpc2_handler *h, size_t size)
+{
+	return h->hooks.malloc_fn ? h->hooks.malloc_fn(size) : malloc(size);
+}
+
+static void cjrpc2_free(const struct cjrpc2_handler *h, void *p)
+{
+	if (h->hooks.free_fn) {
+		h->hooks.free_fn(p);
+	} else {
+		free(p);
 	}
+}
 
-	j_id = cJSON_DetachItemFromObject(j_req, "id");
-	j_params = cJSON_GetObjectItem(j_req, "params");
+static void *cjrpc2_arena_alloc(size_t size)
+{
+	struct cjrpc2_handler *h = cjrpc2_arena_owner;
+	struct cjrpc2_arena *a = h->arena;
+	size_t chunk;
+	void *p;
 
-	/* find function & execute */
-	j_resp = NULL;
-	me = h->mlist_head;
-	while (me) {
-		if (strcmp(me->method->name, j_method->valuestring)) {
-			me = me->next;
-			continue;
+	if (size > SIZE_MAX / 2) {
+		return NULL;
+	}
+	size = (size + CJRPC2_ARENA_ALIGN - 1) & ~(size_t)(CJRPC2_ARENA_ALIGN - 1);
+	if (!a || a->size - a->used < size) {
+		/* start a new chunk, the rest of the current one is wasted */
+		chunk = a ? a->size * 2 : CJRPC2_ARENA_CHUNK_SIZE;
+		if (chunk < size) {
+			chunk = size;
 		}
-		if (me->method->func(j_params, &j_result) == CJRPC2_RET_SUCCESS) {
-			if (j_id) {
-				j_resp = cjrpc2_create_response(j_result, j_id);
-			}
-			goto exit_ret;
+		a = (struct cjrpc2_arena *)cjrpc2_malloc(h, CJRPC2_ARENA_HDR_SIZE + chunk);
+		if (!a) {
+			return NULL;
 		}
-		if (j_id) {
-			j_resp = cjrpc2_create_response_error2(j_result, j_id);
+		a->next = h->arena;
+		a->size = chunk;
+		a->used = 0;
+		h->arena = a;
+	}
+	p = (char *)a + CJRPC2_ARENA_HDR_SIZE + a->used;
+	a->used += size;
+
+	return p;
+}
+
+static void cjrpc2_arena_free(void *p)
+{
+	struct cjrpc2_arena *a;
+	uintptr_t data;
+
+	for (a = cjrpc2_arena_owner->arena; a; a = a->next) {
+		data = (uintptr_t)a + CJRPC2_ARENA_HDR_SIZE;
+		if ((uintptr_t)p >= data && (uintptr_t)p < data + a->size) {
+			/* released with the whole arena */
+			return;
 		}
-		goto exit_ret;
 	}
-	if (j_id) {
-		j_resp = cjrpc2_create_response_error(JSONRPC2_ENOMET, "method not found", NULL,
-						      j_id);
+	/* allocated before the request, with the handler's hooks or else the application's ones */
+	if (cjrpc2_arena_owner->hooks.free_fn) {
+		cjrpc2_arena_owner->hooks.free_fn(p);
+	} else if (cjrpc2_caller_has_hooks) {
+		cjrpc2_caller_hooks.free_fn(p);
+	} else {
+		cJSON_GlobalFree(p);
 	}
+}
 
-exit_ret:
-	if (j_resp) {
-		ret = cJSON_PrintUnformatted(j_resp);
-		cJSON_Delete(j_resp);
+/* route the cJSON allocations of this thread to the arena or hooks of h (NULL: the application's) */
+static void cjrpc2_hooks_install(const struct cjrpc2_handler *h, bool arena)
+{
+	static const cJSON_ThreadHooks arena_hooks = {&cjrpc2_arena_alloc, &cjrpc2_arena_free, NULL};
+
+	if (arena) {
+		cJSON_InitThreadHooks(&arena_hooks);
+	} else if (h && (h->hooks.malloc_fn || h->hooks.free_fn)) {
+		cJSON_InitThreadHooks(&h->hooks);
+	} else if (cjrpc2_caller_has_hooks) {
+		cJSON_InitThreadHooks(&cjrpc2_caller_hooks);
 	} else {
-		/* notification */
-		ret = (char *)malloc(1);
-		if (!ret) {
-			/* errno set by malloc() */
-			return NULL;
-		}
-		*ret = '\0';
+		cJSON_InitThreadHooks(NULL);
 	}
-	cJSON_Delete(j_req);
-	return ret;
 }
 
-enum cjrpc2_param_status cjrpc2_get_param_double(const cJSON *params, const char *name,
-						 double *value)
+/* claim the handler's arena for the request about to be handled by this thread */
+static bool cjrpc2_arena_enter(struct cjrpc2_handler *h)
 {
-	cJSON *p_item;
+	/* nested requests (issued by a method) leave the outer arena alone */
+	if (!(h->flags & CJRPC2_FLAG_ARENA) || cjrpc2_arena_owner ||
+	    !cjrpc2_atomic_cas(&h->arena_busy, 0, 1)) {
+		return false;
+	}
+	cjrpc2_arena_owner = h;
 
-	if (!(p_item = cJSON_GetObjectItem(params, name))) {
-		return PARAM_MISSING;
+	return true;
+}
+
+static void cjrpc2_arena_free_chunks(const struct cjrpc2_handler *h, struct cjrpc2_arena *a)
+{
+	struct cjrpc2_arena *next;
+
+	for (; a; a = next) {
+		next = a->next;
+		cjrpc2_free(h, a);
 	}
-	if (!cJSON_IsNumber(p_item)) {
-		return PARAM_WRONG_TYPE;
+}
+
+/* release everything allocated by the request at once and return the arena to the handler */
+static void cjrpc2_arena_leave(struct cjrpc2_handler *h)
+{
+	struct cjrpc2_arena *a;
+	size_t total = 0;
+
+	cjrpc2_arena_owner = NULL;
+
+	for (a = h->arena; a; a = a->next) {
+		total += a->size;
+	}
+	if (h->arena && !h->arena->next && total <= CJRPC2_ARENA_KEEP_MAX) {
+		h->arena->used = 0;
+	} else {
+		/* merge the chunks, so the next request of this size fits into one */
+		cjrpc2_arena_free_chunks(h, h->arena);
+		h->arena = NULL;
+		if (total && total <= CJRPC2_ARENA_KEEP_MAX &&
+		    (a = (struct cjrpc2_arena *)cjrpc2_malloc(h, CJRPC2_ARENA_HDR_SIZE + total))) {
+			a->next = NULL;
+			a->size = total;
+			a->used = 0;
+			h->arena = a;
+		}
 	}
 
-	*value = cJSON_GetNumberValue(p_item);
-	return PARAM_OK;
+	cjrpc2_atomic_store(&h->arena_busy, 0);
 }
 
-enum cjrpc2_param_status cjrpc2_get_param_double_range(const cJSON *params, const char *name,
-						       double *value, const double min,
-						       const double max)
+/* count methods and the bytes needed to store their names under prefix */
+static void cjrpc2_mount_size(const char *prefix, const struct cjrpc2_method *methods,
+			      size_t *mcount, size_t *names_size)
 {
-	enum cjrpc2_param_status pstat;
-	double dval;
+	size_t i;
 
-	if (PARAM_OK != (pstat = cjrpc2_get_param_double(params, name, &dval))) {
-		return pstat;
+	for (i = 0; methods && methods[i].name; i++) {
+		(*mcount)++;
+		if (prefix && *prefix) {
+			*names_size += strlen(prefix) + 1 + strlen(methods[i].name) + 1;
+		}
 	}
+}
 
-	if (dval < min || dval > max) {
-		return PARAM_OO_RANGE;
+/* create a handler with room for mcount methods and names_size bytes of method names */
+static struct cjrpc2_handler *cjrpc2_alloc_handler(size_t mcount, size_t names_size)
+{
+	struct cjrpc2_handler *h;
+
+	/* the method table and names directly follow the handler in a single allocation */
+	h = (struct cjrpc2_handler *)calloc(1, sizeof(struct cjrpc2_handler) +
+						       cjrpc2_mtable_size(mcount) + names_size);
+	if (!h) {
+		errno = ENOMEM;
+		return NULL;
 	}
+	h->mtable = h->mtable_embedded = (struct cjrpc2_mtable *)(h + 1);
+	cjrpc2_mtable_init(h->mtable, mcount);
+	h->stable = NULL;
+	h->is_static = false;
 
-	*value = dval;
-	return PARAM_OK;
+	return h;
 }
 
-enum cjrpc2_param_status cjrpc2_get_param_int(const cJSON *params, const char *name, int *value)
+/* register methods under prefix, prefixed names are stored at *names */
+static int cjrpc2_mount(struct cjrpc2_handler *h, const char *prefix,
+			const struct cjrpc2_method *methods, char **names)
 {
-	return cjrpc2_get_param_int_range(params, name, value, INT_MIN, INT_MAX);
+	const char *name;
+	size_t i;
+	int ret;
+
+	for (i = 0; methods && methods[i].name; i++) {
+		name = methods[i].name;
+		if (prefix && *prefix) {
+			name = *names;
+			*names += sprintf(*names, "%s.%s", prefix, methods[i].name) + 1;
+		}
+		ret = cjrpc2_mtable_insert(h->mtable, name, methods[i].func);
+		if (ret && ret != -EEXIST) {
+			return ret;
+		}
+	}
+
+	return 0;
 }
 
-enum cjrpc2_param_status cjrpc2_get_param_int_range(const cJSON *params, const char *name,
-						    int *value, const int min, const int max)
+struct cjrpc2_handler *cjrpc2_new_handler(struct cjrpc2_method *methods)
 {
-	enum cjrpc2_param_status pstat;
-	double dval;
+	return cjrpc2_new_handler_m(1, methods);
+}
 
-	if (PARAM_OK != (pstat = cjrpc2_get_param_double_range(params, name, &dval, min, max))) {
-		return pstat;
+struct cjrpc2_handler *cjrpc2_new_handler_m(size_t count, ...)
+{
+	va_list ap, aq;
+	struct cjrpc2_handler *h;
+	size_t mcount, names_size;
+	unsigned int j;
+	int ret;
+
+	if (!count) {
+		errno = EINVAL;
+		return NULL;
 	}
 
-	if (floor(dval) != dval) {
-		return PARAM_NUM_NOINT;
+	/* count methods to size the table */
+	mcount = names_size = 0;
+	va_start(ap, count);
+	va_copy(aq, ap);
+	for (j = 0; j < count; j++) {
+		cjrpc2_mount_size(NULL, va_arg(ap, struct cjrpc2_method *), &mcount, &names_size);
 	}
+	va_end(ap);
 
-	*value = (int)dval;
-	return PARAM_OK;
+	h = cjrpc2_alloc_handler(mcount, names_size);
+	if (!h) {
+		va_end(aq);
+		/* errno set by cjrpc2_alloc_handler() */
+		return NULL;
+	}
+
+	for (j = 0; j < count; j++) {
+		if ((ret = cjrpc2_mount(h, NULL, va_arg(aq, struct cjrpc2_method *), NULL))) {
+			va_end(aq);
+			cjrpc2_free_handler(h);
+			errno = -ret;
+			return NULL;
+		}
+	}
+	va_end(aq);
+
+	return h;
 }
 
-enum cjrpc2_param_status cjrpc2_get_param_bool(const cJSON *params, const char *name, bool *value)
+struct cjrpc2_handler *cjrpc2_new_handler_mounts(const struct cjrpc2_mount *mounts)
 {
-	cJSON *p_item;
+	struct cjrpc2_handler *h;
+	size_t mcount, names_size, j;
+	char *names;
+	int ret;
 
-	if (!(p_item = cJSON_GetObjectItem(params, name))) {
-		return PARAM_MISSING;
+	if (!mounts) {
+		errno = EINVAL;
+		return NULL;
 	}
-	if (!cJSON_IsBool(p_item)) {
-		return PARAM_WRONG_TYPE;
+
+	mcount = names_size = 0;
+	for (j = 0; mounts[j].methods; j++) {
+		cjrpc2_mount_size(mounts[j].prefix, mounts[j].methods, &mcount, &names_size);
 	}
 
-	*value = cJSON_IsTrue(p_item);
-	return PARAM_OK;
+	h = cjrpc2_alloc_handler(mcount, names_size);
+	if (!h) {
+		/* errno set by cjrpc2_alloc_handler() */
+		return NULL;
+	}
+
+	names = (char *)h + sizeof(struct cjrpc2_handler) + cjrpc2_mtable_size(mcount);
+	for (j = 0; mounts[j].methods; j++) {
+		if ((ret = cjrpc2_mount(h, mounts[j].prefix, mounts[j].methods, &names))) {
+			cjrpc2_free_handler(h);
+			errno = -ret;
+			return NULL;
+		}
+	}
+
+	return h;
 }
 
-enum cjrpc2_param_status cjrpc2_get_param_string(const cJSON *params, const char *name,
-						 char **value)
+struct cjrpc2_handler *cjrpc2_new_handler_static(struct cjrpc2_handler *h,
+						 const struct cjrpc2_static_table *table)
 {
-	cJSON *p_item;
-	char *json_str;
-	size_t value_size;
+	if (!h || !table) {
+		errno = EINVAL;
+		return NULL;
+	}
 
-	if (!(p_item = cJSON_GetObjectItem(params, name))) {
-		return PARAM_MISSING;
+	memset(h, 0, sizeof(struct cjrpc2_handler));
+	h->stable = table;
+	h->is_static = true;
+
+	return h;
+}
+
+void cjrpc2_free_handler(struct cjrpc2_handler *h)
+{
+	if (!h) {
+		return;
 	}
-	if (!cJSON_IsString(p_item)) {
-		return PARAM_WRONG_TYPE;
+	if (h->mtable != h->mtable_embedded) {
+		free(h->mtable);
 	}
-	json_str = cJSON_GetStringValue(p_item);
-	value_size = strlen(json_str) + 1;
-
-	if (!(*value = (char *)malloc(value_size))) {
-		return PARAM_NOMEM;
+	cjrpc2_arena_free_chunks(h, h->arena);
+	if (!h->is_static) {
+		free(h);
 	}
+}
 
-	strncpy(*value, json_str, value_size);
+int cjrpc2_register_method(struct cjrpc2_handler *h, const char *name,
+			   int (*func)(const cJSON *params, cJSON **resp))
+{
+	struct cjrpc2_mtable *t;
+	uint32_t hash;
+	size_t len;
+	int ret;
+
+	if (!h || !name || !func) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	cjrpc2_writer_lock(h);
+	hash = cjrpc2_hash(name, &len);
+	if (cjrpc2_find(h->stable, h->mtable, name, len, hash, false)) {
+		cjrpc2_writer_unlock(h);
+		errno = EEXIST;
+		return -1;
+	}
+	t = cjrpc2_mtable_copy(h->mtable, 1, NULL);
+	if (!t) {
+		cjrpc2_writer_unlock(h);
+		errno = ENOMEM;
+		return -1;
+	}
+	if ((ret = cjrpc2_mtable_insert(t, name, func))) {
+		cjrpc2_writer_unlock(h);
+		free(t);
+		errno = -ret;
+		return -1;
+	}
+	cjrpc2_mtable_replace(h, t);
+	cjrpc2_writer_unlock(h);
+
+	return 0;
+}
+
+int cjrpc2_unregister_method(struct cjrpc2_handler *h, const char *name)
+{
+	const struct cjrpc2_method_entry *me;
+	struct cjrpc2_mtable *t;
+	uint32_t hash;
+	size_t len;
+
+	if (!h || !name) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	cjrpc2_writer_lock(h);
+	hash = cjrpc2_hash(name, &len);
+	me = cjrpc2_mtable_find(h->mtable, name, len, hash, false);
+	if (!me) {
+		cjrpc2_writer_unlock(h);
+		/* methods of a static table can't be removed */
+		errno = cjrpc2_stable_find(h->stable, name, len, hash, false) ? EPERM : ENOENT;
+		return -1;
+	}
+	t = cjrpc2_mtable_copy(h->mtable, 0, me);
+	if (!t) {
+		cjrpc2_writer_unlock(h);
+		errno = ENOMEM;
+		return -1;
+	}
+	cjrpc2_mtable_replace(h, t);
+	cjrpc2_writer_unlock(h);
+
+	return 0;
+}
+
+/* parse error response, with the offset of the error in the request if enabled on the handler */
+static cJSON *cjrpc2_parse_error(const struct cjrpc2_handler *h, size_t offset)
+{
+	cJSON *data = NULL;
+
+	if (h->flags & CJRPC2_FLAG_ERROR_OFFSET) {
+		data = cJSON_CreateObject();
+		if (data && !cJSON_AddNumberToObject(data, "offset", (double)offset)) {
+			cJSON_Delete(data);
+			data = NULL;
+		}
+	}
+
+	return cjrpc2_create_response_error(JSONRPC2_EPARSE, "parse error", data, NULL);
+}
+
+/* the request was refused at one of the limits of the handler, without looking any further */
+static cJSON *cjrpc2_limit_error(void)
+{
+	return cjrpc2_create_response_error(JSONRPC2_EIREQ, "limit exceeded", NULL, NULL);
+}
+
+/* find function & execute, takes ownership of j_id */
+static cJSON *cjrpc2_dispatch(struct cjrpc2_handler *h, const char *method, const cJSON *j_params,
+			      cJSON *j_id)
+{
+	cjrpc2_func func;
+	cJSON *j_result;
+
+	func = cjrpc2_lookup_func(h, method);
+	if (!func) {
+		if (!j_id) {
+			return NULL;
+		}
+		return cjrpc2_create_response_error(JSONRPC2_ENOMET, "method not found", NULL, j_id);
+	}
+
+	j_result = NULL;
+	cjrpc2_current->params = j_params;
+	if (func(j_params, &j_result) == CJRPC2_RET_SUCCESS) {
+		if (j_id) {
+			return cjrpc2_create_response(j_result, j_id);
+		}
+	} else if (j_id) {
+		return cjrpc2_create_response_error2(j_result, j_id);
+	}
+
+	/* notification */
+	cJSON_Delete(j_result);
+	return NULL;
+}
+
+static char *cjrpc2_print_response(cJSON *j_resp)
+{
+	char *ret;
+
+	if (j_resp) {
+		ret = cJSON_PrintUnformatted(j_resp);
+	} else {
+		/* notification */
+		ret = (char *)cJSON_malloc(1);
+		if (!ret) {
+			errno = ENOMEM;
+			return NULL;
+		}
+		*ret = '\0';
+	}
+
+	return ret;
+}
+
+static const char *cjrpc2_scan_ws(const char *p, const char *end)
+{
+	/* same as cJSON's buffer_skip_whitespace() */
+	while (p < end && (unsigned char)*p <= 32) {
+		p++;
+	}
+
+	return p;
+}
+
+/* p points to the opening quote, returns the position after the closing quote */
+static const char *cjrpc2_scan_string(const char *p, const char *end)
+{
+	for (p++; p < end; p++) {
+		if (*p == '"') {
+			return p + 1;
+		}
+		if (*p == '\\' && ++p == end) {
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * skip a JSON value, only its structure is checked (strings, brackets, separators), the value
+ * itself is validated once it gets parsed by cJSON, *error is set where malformed input is found
+ * (like cJSON, one byte into a broken string)
+ */
+static const char *cjrpc2_scan_value(const char *p, const char *end, unsigned int depth,
+				     const char **error)
+{
+	const char *start;
+	char close;
+
+	if (p == end) {
+		goto fail;
+	}
+
+	switch (*p) {
+	case '"':
+		start = p;
+		if (!(p = cjrpc2_scan_string(start, end))) {
+			p = start + 1;
+			goto fail;
+		}
+		return p;
+	case '{':
+	case '[':
+		if (depth >= CJSON_NESTING_LIMIT) {
+			goto fail;
+		}
+		close = *p == '{' ? '}' : ']';
+		p = cjrpc2_scan_ws(p + 1, end);
+		if (p < end && *p == close) {
+			return p + 1;
+		}
+		for (;;) {
+			if (close == '}') {
+				start = p;
+				if (p == end || *p != '"' || !(p = cjrpc2_scan_string(p, end))) {
+					p = start + 1;
+					goto fail;
+				}
+				p = cjrpc2_scan_ws(p, end);
+				if (p == end || *p != ':') {
+					goto fail;
+				}
+				p = cjrpc2_scan_ws(p + 1, end);
+			}
+			if (!(p = cjrpc2_scan_value(p, end, depth + 1, error))) {
+				return NULL;
+			}
+			p = cjrpc2_scan_ws(p, end);
+			if (p == end || (*p != close && *p != ',')) {
+				goto fail;
+			}
+			if (*p == close) {
+				return p + 1;
+			}
+			p = cjrpc2_scan_ws(p + 1, end);
+		}
+	default:
+		/* numbers and literals */
+		for (start = p; p < end; p++) {
+			if (!((*p >= '0' && *p <= '9') || (*p >= 'a' && *p <= 'z') || *p == '-' ||
+			      *p == '+' || *p == '.' || *p == 'E')) {
+				break;
+			}
+		}
+		if (p == start) {
+			goto fail;
+		}
+		return p;
+	}
+
+fail:
+	*error = p;
+
+	return NULL;
+}
+
+/*
+ * NULL terminated value of the JSON string s (including the quotes), either copied to buf or
+ * decoded by cJSON into *tmp (must be cJSON_Delete()'d by the caller)
+ */
+static const char *cjrpc2_slice_string(const struct cjrpc2_slice *s, char *buf, size_t size,
+				       cJSON **tmp)
+{
+	if (s->len - 2 < size && !memchr(s->ptr, '\\', s->len)) {
+		memcpy(buf, s->ptr + 1, s->len - 2);
+		buf[s->len - 2] = '\0';
+		return buf;
+	}
+	*tmp = cJSON_ParseWithLength(s->ptr, s->len);
+
+	return cJSON_GetStringValue(*tmp);
+}
+
+/* case insensitive like cJSON_GetObjectItem() */
+static bool cjrpc2_slice_key_equal(const struct cjrpc2_slice *key, const char *name)
+{
+	char buf[16];
+	cJSON *tmp = NULL;
+	const char *k;
+	bool ret;
+
+	k = cjrpc2_slice_string(key, buf, sizeof(buf), &tmp);
+	for (ret = k != NULL; ret && (*k || *name); k++, name++) {
+		ret = tolower((unsigned char)*k) == tolower((unsigned char)*name);
+	}
+	cJSON_Delete(tmp);
+
+	return ret;
+}
+
+/* locate the top level members of a request without parsing their values */
+static int cjrpc2_scan_envelope(const char *req, size_t len, struct cjrpc2_envelope *env)
+{
+	struct cjrpc2_slice key, *member;
+	const char *p, *end;
+
+	memset(env, 0, sizeof(struct cjrpc2_envelope));
+	if (!req) {
+		return JSONRPC2_EPARSE;
+	}
+	end = req + len;
+	p = cjrpc2_scan_ws(req, end);
+	if (p == end || *p != '{') {
+		/* valid JSON, but not an object */
+		p = cjrpc2_scan_value(p, end, 0, &env->error);
+		return p ? JSONRPC2_EIREQ : JSONRPC2_EPARSE;
+	}
+
+	p = cjrpc2_scan_ws(p + 1, end);
+	if (p < end && *p == '}') {
+		return JSONRPC2_EIREQ;
+	}
+	for (;;) {
+		key.ptr = p;
+		if (p == end || *p != '"' || !(p = cjrpc2_scan_string(p, end))) {
+			p = key.ptr + 1;
+			goto fail;
+		}
+		key.len = (size_t)(p - key.ptr);
+		p = cjrpc2_scan_ws(p, end);
+		if (p == end || *p != ':') {
+			goto fail;
+		}
+		p = cjrpc2_scan_ws(p + 1, end);
+
+		member = NULL;
+		if (cjrpc2_slice_key_equal(&key, "jsonrpc")) {
+			member = &env->jsonrpc;
+		} else if (cjrpc2_slice_key_equal(&key, "method")) {
+			member = &env->method;
+		} else if (cjrpc2_slice_key_equal(&key, "params")) {
+			member = &env->params;
+		} else if (cjrpc2_slice_key_equal(&key, "id")) {
+			member = &env->id;
+		}
+		/* the first occurrence wins like with cJSON_GetObjectItem() */
+		if (member && member->ptr) {
+			member = NULL;
+		}
+		if (member) {
+			member->ptr = p;
+		}
+		if (!(p = cjrpc2_scan_value(p, end, 1, &env->error))) {
+			return JSONRPC2_EPARSE;
+		}
+		if (member) {
+			member->len = (size_t)(p - member->ptr);
+		}
+
+		p = cjrpc2_scan_ws(p, end);
+		if (p == end || (*p != '}' && *p != ',')) {
+			goto fail;
+		}
+		if (*p == '}') {
+			return 0;
+		}
+		p = cjrpc2_scan_ws(p + 1, end);
+	}
+
+fail:
+	env->error = p;
+
+	return JSONRPC2_EPARSE;
+}
+
+/* offset of the malformed input found by cjrpc2_scan_envelope(), counted like cJSON does */
+static size_t cjrpc2_error_offset(const struct cjrpc2_envelope *env, const char *req, size_t len)
+{
+	if (!env->error) {
+		return 0;
+	}
+	/* cJSON reports running out of input at the last byte */
+	if ((size_t)(env->error - req) >= len) {
+		return len ? len - 1 : 0;
+	}
+
+	return (size_t)(env->error - req);
+}
+
+static cJSON *cjrpc2_respond_lazy(struct cjrpc2_handler *h, const char *req, char *in_situ,
+				  size_t len)
+{
+	struct cjrpc2_envelope env;
+	struct cjrpc2_lazy_params lp;
+	char method_buf[CJRPC2_LAZY_METHOD_SIZE], version_buf[sizeof(JSONRPC2_VERSION)];
+	const char *method, *version, *end;
+	cJSON *j_method, *j_version, *j_id, *j_resp;
+	int ret;
+
+	j_method = j_version = j_id = NULL;
+	ret = cjrpc2_scan_envelope(req, len, &env);
+	if (ret == JSONRPC2_EPARSE) {
+		j_resp = cjrpc2_parse_error(h, cjrpc2_error_offset(&env, req, len));
+		goto exit_ret;
+	}
+
+	version = method = NULL;
+	if (!ret && env.jsonrpc.ptr && *env.jsonrpc.ptr == '"' && env.method.ptr &&
+	    *env.method.ptr == '"') {
+		version = cjrpc2_slice_string(&env.jsonrpc, version_buf, sizeof(version_buf),
+					      &j_version);
+		method = cjrpc2_slice_string(&env.method, method_buf, sizeof(method_buf),
+					     &j_method);
+	}
+	if (!version || strcmp(version, JSONRPC2_VERSION) || !method) {
+		j_resp =
+			cjrpc2_create_response_error(JSONRPC2_EIREQ, "invalid request", NULL, NULL);
+		goto exit_ret;
+	}
+
+	if (env.id.ptr && !(j_id = cJSON_ParseWithLengthOpts(env.id.ptr, env.id.len, &end, false))) {
+		j_resp = cJSON_GetErrorLimit() ? cjrpc2_limit_error()
+					       : cjrpc2_parse_error(h, (size_t)(end - req));
+		goto exit_ret;
+	}
+
+	memset(&lp, 0, sizeof(struct cjrpc2_lazy_params));
+	lp.item.type = CJRPC2_TYPE_LAZY;
+	lp.raw = env.params.ptr;
+	lp.in_situ = in_situ && lp.raw ? in_situ + (lp.raw - req) : NULL;
+	lp.len = env.params.len;
+
+	j_resp = cjrpc2_dispatch(h, method, env.params.ptr ? &lp.item : NULL, j_id);
+	if (lp.cursor.token == cJSON_TokenError && !lp.failed) {
+		/* the method's cursor ran into invalid params (or a limit) */
+		lp.failed = true;
+		lp.limit = lp.cursor.limit;
+		lp.error = lp.cursor.offset;
+	}
+	cJSON_CursorFree(&lp.cursor);
+	if (lp.failed) {
+		/* the method got PARAM_EPARSE, report the malformed request instead of its result */
+		cJSON_Delete(j_resp);
+		j_resp = lp.limit ? cjrpc2_limit_error()
+				  : cjrpc2_parse_error(h, (size_t)(lp.raw - req) + lp.error);
+	}
+	cJSON_Delete(lp.tree);
+
+exit_ret:
+	cJSON_Delete(j_method);
+	cJSON_Delete(j_version);
+	return j_resp;
+}
+
+/* build the response to req, *j_req is the request tree (valid until the response is printed) */
+static cJSON *cjrpc2_respond(struct cjrpc2_handler *h, const char *req, char *in_situ, size_t len,
+			     cJSON **j_req)
+{
+	cJSON *j_reqjsonrpc, *j_method, *j_params, *j_id;
+	const char *end = req;
+
+	/* parse and validate request */
+	if (in_situ) {
+		*j_req = cJSON_ParseInSitu(in_situ, len, &end, false);
+	} else {
+		*j_req = cJSON_ParseWithLengthOpts(req, len, &end, false);
+	}
+	if (!*j_req) {
+		return cJSON_GetErrorLimit() ? cjrpc2_limit_error()
+					     : cjrpc2_parse_error(h, (size_t)(end - req));
+	}
+
+	j_reqjsonrpc = cJSON_GetObjectItem(*j_req, "jsonrpc");
+	j_method = cJSON_GetObjectItem(*j_req, "method");
+	if (!j_reqjsonrpc || !cJSON_IsString(j_reqjsonrpc) ||
+	    strcmp(j_reqjsonrpc->valuestring, JSONRPC2_VERSION) || !j_method ||
+	    !cJSON_IsString(j_method) || !j_method->valuestring) {
+		return cjrpc2_create_response_error(JSONRPC2_EIREQ, "invalid request", NULL, NULL);
+	}
+
+	j_id = cJSON_DetachItemFromObject(*j_req, "id");
+	j_params = cJSON_GetObjectItem(*j_req, "params");
+
+	return cjrpc2_dispatch(h, j_method->valuestring, j_params, j_id);
+}
+
+/* case insensitive like cJSON_GetObjectItem() */
+static bool cjrpc2_member_equal(const char *a, const char *b)
+{
+	for (; *a || *b; a++, b++) {
+		if (tolower((unsigned char)*a) != tolower((unsigned char)*b)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* linear search in a tape object, returns the entry of the value or 0 if missing */
+static size_t cjrpc2_tape_scan(const cJSON_Tape *tape, size_t object, const char *name,
+			       const struct cjrpc2_param_key *key)
+{
+	const char *member;
+	size_t i, end, len;
+
+	if (cJSON_TapeType(tape->entries[object]) != '{') {
+		return 0;
+	}
+	end = cJSON_TapeSkip(tape, object) - 1;
+	for (i = object + 1; i < end; i = cJSON_TapeSkip(tape, i + 1)) {
+		member = cJSON_TapeGetString(tape, i, &len);
+		/* tape strings know their length, so keys of another length are skipped right away */
+		if (key ? len == key->len && !memcmp(member, key->name, len)
+			: cjrpc2_member_equal(member, name)) {
+			return i + 1;
+		}
+	}
+
+	return 0;
+}
+
+/* build the response to req, *tape is the parsed request (valid until the response is printed) */
+static cJSON *cjrpc2_respond_tape(struct cjrpc2_handler *h, const char *req, size_t len,
+				  cJSON_Tape **tape)
+{
+	struct cjrpc2_tape_params tp;
+	const char *version, *method, *end = req;
+	size_t i_params, i_id;
+	cJSON *j_id, *j_resp;
+
+	if (!(*tape = cJSON_ParseTape(req, len, &end))) {
+		return cJSON_GetErrorLimit() ? cjrpc2_limit_error()
+					     : cjrpc2_parse_error(h, (size_t)(end - req));
+	}
+
+	version = method = NULL;
+	if (cJSON_TapeType((*tape)->entries[0]) == '{') {
+		version = cJSON_TapeGetString(*tape, cjrpc2_tape_scan(*tape, 0, "jsonrpc", NULL),
+					      NULL);
+		method = cJSON_TapeGetString(*tape, cjrpc2_tape_scan(*tape, 0, "method", NULL), NULL);
+	}
+	if (!version || strcmp(version, JSONRPC2_VERSION) || !method) {
+		return cjrpc2_create_response_error(JSONRPC2_EIREQ, "invalid request", NULL, NULL);
+	}
+
+	j_id = NULL;
+	if ((i_id = cjrpc2_tape_scan(*tape, 0, "id", NULL)) &&
+	    !(j_id = cJSON_TapeToItem(*tape, i_id))) {
+		errno = ENOMEM;
+		return cjrpc2_create_response_error(JSONRPC2_EINTERN, "internal error", NULL, NULL);
+	}
+
+	memset(&tp, 0, sizeof(struct cjrpc2_tape_params));
+	tp.item.type = CJRPC2_TYPE_TAPE;
+	tp.tape = *tape;
+	tp.index = i_params = cjrpc2_tape_scan(*tape, 0, "params", NULL);
+
+	j_resp = cjrpc2_dispatch(h, method, i_params ? &tp.item : NULL, j_id);
+	cJSON_Delete(tp.tree);
+
+	return j_resp;
+}
+
+/* handle req, which is parsed in place if in_situ (a writable alias of req) is given */
+static char *cjrpc2_handle(struct cjrpc2_handler *h, const char *req, char *in_situ, size_t len)
+{
+	struct cjrpc2_request request, *outer;
+	struct cjrpc2_member_index *index;
+	struct cjrpc2_array_index *array;
+	cJSON *j_req, *j_resp;
+	cJSON_Tape *tape;
+	bool arena;
+	char *ret;
+
+	if (!h) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	if (!cjrpc2_current) {
+		cjrpc2_caller_has_hooks = cJSON_GetThreadHooks(&cjrpc2_caller_hooks);
+		cJSON_GetThreadLimits(&cjrpc2_caller_limits);
+	}
+	request.h = h;
+	request.outer = cjrpc2_current;
+	request.params = NULL;
+	request.indexes = NULL;
+	request.arrays = NULL;
+	cjrpc2_current = &request;
+	arena = cjrpc2_arena_enter(h);
+	cjrpc2_hooks_install(h, arena);
+	cJSON_InitThreadLimits(&h->limits);
+
+	j_req = NULL;
+	tape = NULL;
+	if (h->limits.max_length && len > h->limits.max_length) {
+		j_resp = cjrpc2_limit_error();
+	} else if (h->flags & CJRPC2_FLAG_TAPE) {
+		j_resp = cjrpc2_respond_tape(h, req, len, &tape);
+	} else if (h->flags & CJRPC2_FLAG_LAZY_PARAMS) {
+		j_resp = cjrpc2_respond_lazy(h, req, in_situ, len);
+	} else {
+		j_resp = cjrpc2_respond(h, req, in_situ, len, &j_req);
+	}
+	while ((index = request.indexes)) {
+		request.indexes = index->next;
+		cJSON_free(index);
+	}
+	while ((array = request.arrays)) {
+		request.arrays = array->next;
+		cJSON_free(array);
+	}
+
+	if (arena) {
+		/* the response string is handed to the caller, it must not come from the arena */
+		cjrpc2_hooks_install(h, false);
+		ret = cjrpc2_print_response(j_resp);
+		/* both trees (or the tape) go with the arena */
+		cjrpc2_arena_leave(h);
+	} else {
+		ret = cjrpc2_print_response(j_resp);
+		cJSON_Delete(j_resp);
+		cJSON_Delete(j_req);
+		cJSON_DeleteTape(tape);
+	}
+
+	cjrpc2_current = outer = request.outer;
+	if (outer) {
+		cjrpc2_hooks_install(outer->h, cjrpc2_arena_owner == outer->h);
+		cJSON_InitThreadLimits(&outer->h->limits);
+	} else {
+		cjrpc2_hooks_install(NULL, false);
+		cJSON_InitThreadLimits(&cjrpc2_caller_limits);
+	}
+
+	return ret;
+}
+
+char *cjrpc2_handle_request(struct cjrpc2_handler *h, const char *req)
+{
+	return cjrpc2_handle_request_len(h, req, req ? strlen(req) : 0);
+}
+
+char *cjrpc2_handle_request_len(struct cjrpc2_handler *h, const char *req, size_t len)
+{
+	return cjrpc2_handle(h, req, NULL, len);
+}
+
+char *cjrpc2_handle_request_insitu(struct cjrpc2_handler *h, char *req, size_t len)
+{
+	return cjrpc2_handle(h, req, req, len);
+}
+
+void cjrpc2_stream_init(struct cjrpc2_stream *s)
+{
+	memset(s, 0, sizeof(struct cjrpc2_stream));
+	s->state = CJRPC2_STREAM_VALUE;
+}
+
+void cjrpc2_stream_free(struct cjrpc2_stream *s)
+{
+	if (s) {
+		free(s->buf);
+		cjrpc2_stream_init(s);
+	}
+}
+
+/* pass ret on unless the request at the start of the buffer, or the one after it, is too long */
+static int cjrpc2_stream_bound(struct cjrpc2_stream *s, int ret)
+{
+	if (!s->max_len || ((s->end ? s->end : s->len) <= s->max_len &&
+			    s->len - s->end <= s->max_len)) {
+		return ret;
+	}
+
+	/* the rest of the request would have to be skipped unscanned, give up on the stream */
+	s->broken = true;
+	s->end = 0;
+	s->scanned = s->len;
+	errno = EMSGSIZE;
+
+	return -1;
+}
+
+/*
+ * resume scanning for the end of the request at the start of the buffer, only its structure is
+ * tracked (strings and brackets), the request is validated once it gets parsed
+ */
+static int cjrpc2_stream_scan(struct cjrpc2_stream *s)
+{
+	const char *p, *end;
+
+	if (s->end) {
+		return cjrpc2_stream_bound(s, 1);
+	}
+	if (s->broken) {
+		errno = EPROTO;
+		return -1;
+	}
+
+	end = s->buf + s->len;
+	for (p = s->buf + s->scanned; p < end; p++) {
+		switch (s->state) {
+		case CJRPC2_STREAM_VALUE:
+			if ((unsigned char)*p <= 32) {
+				break;
+			}
+			if (*p != '{' && *p != '[') {
+				goto malformed;
+			}
+			s->state = CJRPC2_STREAM_STRUCT;
+			s->depth = 1;
+			break;
+		case CJRPC2_STREAM_STRING:
+			while (p < end && *p != '"' && *p != '\\') {
+				p++;
+			}
+			if (p == end) {
+				p--;
+			} else if (*p == '"') {
+				s->state = CJRPC2_STREAM_STRUCT;
+			} else {
+				s->state = CJRPC2_STREAM_ESCAPE;
+			}
+			break;
+		case CJRPC2_STREAM_ESCAPE:
+			s->state = CJRPC2_STREAM_STRING;
+			break;
+		default:
+			if (*p == '"') {
+				s->state = CJRPC2_STREAM_STRING;
+			} else if (*p == '{' || *p == '[') {
+				if (++s->depth > CJSON_NESTING_LIMIT) {
+					goto malformed;
+				}
+			} else if ((*p == '}' || *p == ']') && !--s->depth) {
+				s->end = (size_t)(p + 1 - s->buf);
+				s->scanned = s->end;
+				return cjrpc2_stream_bound(s, 1);
+			}
+			break;
+		}
+	}
+	s->scanned = s->len;
+
+	return cjrpc2_stream_bound(s, 0);
+
+malformed:
+	/* handed to the parser up to here for a parse error, the next request can't be found */
+	s->broken = true;
+	s->end = (size_t)(p + 1 - s->buf);
+	s->scanned = s->end;
+
+	return 1;
+}
+
+char *cjrpc2_stream_space(struct cjrpc2_stream *s, size_t *size)
+{
+	size_t new_size;
+	char *buf;
+
+	if (!s || !size) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	if (s->size - s->len < CJRPC2_STREAM_CHUNK_SIZE) {
+		new_size = s->size ? s->size : CJRPC2_STREAM_CHUNK_SIZE;
+		while (new_size - s->len < CJRPC2_STREAM_CHUNK_SIZE) {
+			if (new_size > SIZE_MAX / 2) {
+				errno = ENOMEM;
+				return NULL;
+			}
+			new_size *= 2;
+		}
+		if (!(buf = (char *)realloc(s->buf, new_size))) {
+			/* errno set by realloc() */
+			return NULL;
+		}
+		s->buf = buf;
+		s->size = new_size;
+	}
+
+	*size = s->size - s->len;
+	return s->buf + s->len;
+}
+
+int cjrpc2_stream_commit(struct cjrpc2_stream *s, size_t len)
+{
+	if (!s || len > s->size - s->len) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (s->broken && !s->end) {
+		/* nothing to look for anymore */
+		errno = EPROTO;
+		return -1;
+	}
+	s->len += len;
+
+	return cjrpc2_stream_scan(s);
+}
+
+int cjrpc2_stream_feed(struct cjrpc2_stream *s, const char *data, size_t len)
+{
+	size_t size, n;
+	char *space;
+	int ret;
+
+	if (!s || (!data && len)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	do {
+		if (!(space = cjrpc2_stream_space(s, &size))) {
+			return -1;
+		}
+		n = len < size ? len : size;
+		memcpy(space, data, n);
+		if ((ret = cjrpc2_stream_commit(s, n)) < 0) {
+			return ret;
+		}
+		data += n;
+		len -= n;
+	} while (len);
+
+	return ret;
+}
+
+char *cjrpc2_stream_handle(struct cjrpc2_handler *h, struct cjrpc2_stream *s)
+{
+	char *ret;
+	int err;
+
+	if (!h || !s) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if (!s->end) {
+		errno = s->broken ? EPROTO : EAGAIN;
+		return NULL;
+	}
+
+	ret = cjrpc2_handle_request_insitu(h, s->buf, s->end);
+	err = errno;
+
+	/* the request is dropped either way, it was modified by the in situ parser */
+	if (s->broken) {
+		s->len = s->end;
+	}
+	memmove(s->buf, s->buf + s->end, s->len - s->end);
+	s->len -= s->end;
+	s->scanned = s->end = 0;
+	s->depth = 0;
+	s->state = CJRPC2_STREAM_VALUE;
+	if (!s->broken) {
+		/* the next request may be complete already */
+		(void)cjrpc2_stream_scan(s);
+	}
+
+	errno = err;
+	return ret;
+}
+
+const cJSON *cjrpc2_params(const cJSON *params)
+{
+	struct cjrpc2_lazy_params *lp;
+	struct cjrpc2_tape_params *tp;
+	const char *end;
+
+	if (params && (params->type & CJRPC2_TYPE_TAPE)) {
+		tp = (struct cjrpc2_tape_params *)params;
+		if (!tp->tree && !(tp->tree = cJSON_TapeToItem(tp->tape, tp->index))) {
+			errno = ENOMEM;
+		}
+		return tp->tree;
+	}
+	if (!params || !(params->type & CJRPC2_TYPE_LAZY)) {
+		return params;
+	}
+
+	lp = (struct cjrpc2_lazy_params *)params;
+	if (!lp->tree && !lp->failed) {
+		end = lp->raw;
+		if (lp->in_situ) {
+			lp->tree = cJSON_ParseInSitu(lp->in_situ, lp->len, &end, false);
+			end = lp->raw + (end - lp->in_situ);
+		} else {
+			lp->tree = cJSON_ParseWithLengthOpts(lp->raw, lp->len, &end, false);
+		}
+		lp->failed = !lp->tree;
+		lp->limit = lp->failed && cJSON_GetErrorLimit();
+		lp->error = (size_t)(end - lp->raw);
+	}
+	if (!lp->tree) {
+		errno = EINVAL;
+	}
+
+	return lp->tree;
+}
+
+cJSON_Cursor *cjrpc2_params_cursor(const cJSON *params)
+{
+	struct cjrpc2_lazy_params *lp;
+
+	if (!params || !(params->type & CJRPC2_TYPE_LAZY)) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	lp = (struct cjrpc2_lazy_params *)params;
+	if (lp->tree && lp->in_situ) {
+		/* the raw params were decoded in place by cjrpc2_params() */
+		errno = EINVAL;
+		return NULL;
+	}
+	cJSON_CursorFree(&lp->cursor);
+	cJSON_CursorInit(&lp->cursor, lp->raw, lp->len);
+
+	return &lp->cursor;
+}
+
+/* FNV-1a hash of a member name, of its lower case form unless case_sensitive */
+static uint32_t cjrpc2_member_hash(const char *name, bool case_sensitive, size_t *len)
+{
+	uint32_t hash = CJRPC2_FNV_BASIS;
+	const char *c;
+
+	if (case_sensitive) {
+		return cjrpc2_hash(name, len);
+	}
+	for (c = name; *c; c++) {
+		hash = cjrpc2_hash_step(hash, (char)tolower((unsigned char)*c));
+	}
+	*len = (size_t)(c - name);
+
+	return hash;
+}
+
+static const void *cjrpc2_index_find(const struct cjrpc2_member_index *index, const char *name,
+				     size_t len, uint32_t hash)
+{
+	const struct cjrpc2_index_slot *slot;
+	size_t i;
+
+	for (i = hash & index->mask;; i = (i + 1) & index->mask) {
+		slot = &index->slots[i];
+		if (!slot->item) {
+			return NULL;
+		}
+		/* names of a different length or hash are skipped without looking at them */
+		if (slot->hash != hash || slot->len != len) {
+			continue;
+		}
+		if (index->case_sensitive ? !memcmp(slot->name, name, len)
+					  : cjrpc2_member_equal(slot->name, name)) {
+			return slot->item;
+		}
+	}
+}
+
+/* look up name (case insensitive) or key (case sensitive) in index */
+static const void *cjrpc2_index_lookup(const struct cjrpc2_member_index *index, const char *name,
+				       const struct cjrpc2_param_key *key)
+{
+	size_t len;
+	uint32_t hash;
+
+	if (key) {
+		return cjrpc2_index_find(index, key->name, key->len, key->hash);
+	}
+	hash = cjrpc2_member_hash(name, false, &len);
+
+	return cjrpc2_index_find(index, name, len, hash);
+}
+
+/* empty index for count members of object, hashed by their lower case names unless case_sensitive */
+static struct cjrpc2_member_index *cjrpc2_index_new(const void *object, size_t count,
+						    bool case_sensitive)
+{
+	struct cjrpc2_member_index *index;
+	size_t slots;
+
+	/* at most half full */
+	slots = CJRPC2_INDEX_MIN_MEMBERS * 2;
+	while (slots < count * 2) {
+		slots *= 2;
+	}
+	index = (struct cjrpc2_member_index *)cJSON_malloc(sizeof(struct cjrpc2_member_index) +
+							   slots * sizeof(struct cjrpc2_index_slot));
+	if (!index) {
+		return NULL;
+	}
+	memset(index->slots, 0, slots * sizeof(struct cjrpc2_index_slot));
+	index->object = object;
+	index->case_sensitive = case_sensitive;
+	index->mask = slots - 1;
+
+	return index;
+}
+
+/* members must be added in order so that the first one of equal names is found first */
+static bool cjrpc2_index_add(struct cjrpc2_member_index *index, const char *name, const void *item)
+{
+	size_t i, len;
+	uint32_t hash;
+
+	hash = cjrpc2_member_hash(name, index->case_sensitive, &len);
+	if (len > UINT32_MAX) {
+		/* such a name can't be looked up by the index, so don't pretend to */
+		return false;
+	}
+	for (i = hash & index->mask; index->slots[i].item; i = (i + 1) & index->mask) {
+	}
+	index->slots[i].hash = hash;
+	index->slots[i].len = (uint32_t)len;
+	index->slots[i].name = name;
+	index->slots[i].item = item;
+
+	return true;
+}
+
+/* index of object built by the request in progress (or NULL) */
+static struct cjrpc2_member_index *cjrpc2_index_get(const void *object, bool case_sensitive)
+{
+	struct cjrpc2_member_index *index;
+
+	for (index = cjrpc2_current->indexes; index; index = index->next) {
+		if (index->object == object && index->case_sensitive == case_sensitive) {
+			break;
+		}
+	}
+
+	return index;
+}
+
+/* keep index for the rest of the request in progress */
+static void cjrpc2_index_keep(struct cjrpc2_member_index *index)
+{
+	index->next = cjrpc2_current->indexes;
+	cjrpc2_current->indexes = index;
+}
+
+/* linear search, case sensitive if key is given */
+static cJSON *cjrpc2_object_scan(const cJSON *object, const char *name,
+				 const struct cjrpc2_param_key *key)
+{
+	cJSON *c;
+
+	if (!key) {
+		return cJSON_GetObjectItem(object, name);
+	}
+	for (c = object ? object->child : NULL; c; c = c->next) {
+		if (c->string && !strncmp(c->string, key->name, key->len) && !c->string[key->len]) {
+			return c;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * whether object (or array) is the params tree the request in progress parsed for its method:
+ * methods only get it const, so it can be indexed, unlike items a method builds and changes as it
+ * likes
+ */
+static bool cjrpc2_indexable(const cJSON *object)
+{
+	const cJSON *params;
+
+	if (!cjrpc2_current || !(params = cjrpc2_current->params)) {
+		return false;
+	}
+	if (params->type & CJRPC2_TYPE_LAZY) {
+		params = ((const struct cjrpc2_lazy_params *)params)->tree;
+	} else if (params->type & CJRPC2_TYPE_TAPE) {
+		params = ((const struct cjrpc2_tape_params *)params)->tree;
+	}
+
+	return object == params;
+}
+
+/*
+ * member name of object (case insensitive) or key (case sensitive), params with many members are
+ * indexed for the rest of the request in progress so that reading all of them takes linear instead
+ * of quadratic time
+ */
+static cJSON *cjrpc2_object_item(const cJSON *object, const char *name,
+				 const struct cjrpc2_param_key *key)
+{
+	struct cjrpc2_member_index *index;
+	const cJSON *c;
+	size_t count;
+
+	if (!cJSON_IsObject(object) || !(key ? key->name : name) || !cjrpc2_indexable(object)) {
+		return cjrpc2_object_scan(object, name, key);
+	}
+
+	if (!(index = cjrpc2_index_get(object, key != NULL))) {
+		count = (size_t)cJSON_GetArraySize(object);
+		if (count < CJRPC2_INDEX_MIN_MEMBERS) {
+			return cjrpc2_object_scan(object, name, key);
+		}
+		if (!(index = cjrpc2_index_new(object, count, key != NULL))) {
+			return cjrpc2_object_scan(object, name, key);
+		}
+		/* the index has room for count members, whatever the chain holds */
+		for (c = object->child; c && count > 0; c = c->next, count--) {
+			if (c->string && !cjrpc2_index_add(index, c->string, c)) {
+				cJSON_free(index);
+				return cjrpc2_object_scan(object, name, key);
+			}
+		}
+		cjrpc2_index_keep(index);
+	}
+
+	return (cJSON *)cjrpc2_index_lookup(index, name, key);
+}
+
+/* cjrpc2_object_item() for the object at entry object of tape, returns the entry or 0 if missing */
+static size_t cjrpc2_tape_item(const cJSON_Tape *tape, size_t object, const char *name,
+			       const struct cjrpc2_param_key *key)
+{
+	struct cjrpc2_member_index *index;
+	const uint64_t *item;
+	size_t count, i, end;
+
+	count = (size_t)(cJSON_TapePayload(tape->entries[object]) >> 32);
+	if (!cjrpc2_current || cJSON_TapeType(tape->entries[object]) != '{' ||
+	    count < CJRPC2_INDEX_MIN_MEMBERS || !(key ? key->name : name)) {
+		return key || name ? cjrpc2_tape_scan(tape, object, name, key) : 0;
+	}
+
+	if (!(index = cjrpc2_index_get(&tape->entries[object], key != NULL))) {
+		end = cJSON_TapeSkip(tape, object) - 1;
+		if (count == cJSON_TapeCountMax) {
+			/* saturated */
+			for (count = 0, i = object + 1; i < end; i = cJSON_TapeSkip(tape, i + 1)) {
+				count++;
+			}
+		}
+		if (!(index = cjrpc2_index_new(&tape->entries[object], count, key != NULL))) {
+			return cjrpc2_tape_scan(tape, object, name, key);
+		}
+		for (i = object + 1; i < end; i = cJSON_TapeSkip(tape, i + 1)) {
+			if (!cjrpc2_index_add(index, cJSON_TapeGetString(tape, i, NULL),
+					      &tape->entries[i + 1])) {
+				cJSON_free(index);
+				return cjrpc2_tape_scan(tape, object, name, key);
+			}
+		}
+		cjrpc2_index_keep(index);
+	}
+
+	item = (const uint64_t *)cjrpc2_index_lookup(index, name, key);
+	return item ? (size_t)(item - tape->entries) : 0;
+}
+
+/* index of array built by the request in progress (or NULL) */
+static struct cjrpc2_array_index *cjrpc2_array_index_get(const void *array)
+{
+	struct cjrpc2_array_index *index;
+
+	for (index = cjrpc2_current->arrays; index; index = index->next) {
+		if (index->array == array) {
+			break;
+		}
+	}
+
+	return index;
+}
+
+/* empty index for count elements of array, kept for the rest of the request in progress */
+static struct cjrpc2_array_index *cjrpc2_array_index_new(const void *array, size_t count)
+{
+	struct cjrpc2_array_index *index;
+
+	if (count > (SIZE_MAX - sizeof(struct cjrpc2_array_index)) / sizeof(const void *)) {
+		return NULL;
+	}
+	index = (struct cjrpc2_array_index *)cJSON_malloc(sizeof(struct cjrpc2_array_index) +
+							  count * sizeof(const void *));
+	if (!index) {
+		return NULL;
+	}
+	index->array = array;
+	index->count = count;
+	index->next = cjrpc2_current->arrays;
+	cjrpc2_current->arrays = index;
+
+	return index;
+}
+
+/*
+ * element at position of array, params with many elements are indexed for the rest of the request
+ * in progress so that reading all of them takes linear instead of quadratic time
+ */
+static cJSON *cjrpc2_array_item(const cJSON *array, size_t position)
+{
+	struct cjrpc2_array_index *index;
+	const cJSON *c;
+	size_t count;
+
+	if (!cJSON_IsArray(array) || position >= (size_t)cJSON_GetArraySize(array)) {
+		return NULL;
+	}
+	if (position < CJRPC2_INDEX_MIN_MEMBERS || !cjrpc2_indexable(array)) {
+		for (c = array->child; c && position; c = c->next) {
+			position--;
+		}
+		return (cJSON *)c;
+	}
+
+	if (!(index = cjrpc2_array_index_get(array))) {
+		if (!(index = cjrpc2_array_index_new(array, (size_t)cJSON_GetArraySize(array)))) {
+			for (c = array->child; c && position; c = c->next) {
+				position--;
+			}
+			return (cJSON *)c;
+		}
+		/* the index has room for the counted elements, whatever the chain holds */
+		for (count = 0, c = array->child; c && count < index->count; c = c->next) {
+			index->items[count++] = c;
+		}
+		index->count = count;
+	}
+
+	return position < index->count ? (cJSON *)index->items[position] : NULL;
+}
+
+/* linear search for the entry of an element of the array at entry array of tape (or 0) */
+static size_t cjrpc2_tape_walk(const cJSON_Tape *tape, size_t array, size_t position)
+{
+	size_t i, end;
+
+	end = cJSON_TapeSkip(tape, array) - 1;
+	for (i = array + 1; i < end && position; i = cJSON_TapeSkip(tape, i)) {
+		position--;
+	}
+
+	return i < end ? i : 0;
+}
+
+/* cjrpc2_array_item() for the array at entry array of tape, returns the entry or 0 if missing */
+static size_t cjrpc2_tape_element(const cJSON_Tape *tape, size_t array, size_t position)
+{
+	struct cjrpc2_array_index *index;
+	size_t count, i, end;
+
+	if (cJSON_TapeType(tape->entries[array]) != '[') {
+		return 0;
+	}
+	count = (size_t)(cJSON_TapePayload(tape->entries[array]) >> 32);
+	if (position >= count) {
+		/* only a saturated count may be exceeded */
+		return count == cJSON_TapeCountMax ? cjrpc2_tape_walk(tape, array, position) : 0;
+	}
+	if (!cjrpc2_current || position < CJRPC2_INDEX_MIN_MEMBERS) {
+		return cjrpc2_tape_walk(tape, array, position);
+	}
+
+	/* the index covers the first count elements */
+	if (!(index = cjrpc2_array_index_get(&tape->entries[array]))) {
+		if (!(index = cjrpc2_array_index_new(&tape->entries[array], count))) {
+			return cjrpc2_tape_walk(tape, array, position);
+		}
+		end = cJSON_TapeSkip(tape, array) - 1;
+		for (count = 0, i = array + 1; i < end && count < index->count;
+		     i = cJSON_TapeSkip(tape, i)) {
+			index->items[count++] = &tape->entries[i];
+		}
+	}
+
+	return (size_t)((const uint64_t *)index->items[position] - tape->entries);
+}
+
+struct cjrpc2_param_key cjrpc2_param_key(const char *name)
+{
+	struct cjrpc2_param_key key;
+
+	key.name = name;
+	key.len = 0;
+	key.hash = name ? cjrpc2_hash(name, &key.len) : 0;
+
+	return key;
+}
+
+/*
+ * look up a parameter item by name or key, lazy params are parsed on first access, items of tape
+ * params are filled into scratch
+ */
+static enum cjrpc2_param_status cjrpc2_get_param_item(const cJSON *params, const char *name,
+						      const struct cjrpc2_param_key *key,
+						      cJSON *scratch, cJSON **item)
+{
+	const struct cjrpc2_tape_params *tp;
+	size_t i;
+
+	if (params && (params->type & CJRPC2_TYPE_TAPE)) {
+		tp = (const struct cjrpc2_tape_params *)params;
+		if (!(i = cjrpc2_tape_item(tp->tape, tp->index, name, key)) ||
+		    !cJSON_TapeGetValue(tp->tape, i, scratch)) {
+			return PARAM_MISSING;
+		}
+		*item = scratch;
+		return PARAM_OK;
+	}
+	if (params && (params->type & CJRPC2_TYPE_LAZY) && !(params = cjrpc2_params(params))) {
+		return PARAM_EPARSE;
+	}
+	if (!(*item = cjrpc2_object_item(params, name, key))) {
+		return PARAM_MISSING;
+	}
+
+	return PARAM_OK;
+}
+
+/* cjrpc2_get_param_item() for the element at position of positional params */
+static enum cjrpc2_param_status cjrpc2_get_param_item_at(const cJSON *params, size_t position,
+							 cJSON *scratch, cJSON **item)
+{
+	const struct cjrpc2_tape_params *tp;
+	size_t i;
+
+	if (params && (params->type & CJRPC2_TYPE_TAPE)) {
+		tp = (const struct cjrpc2_tape_params *)params;
+		if (!(i = cjrpc2_tape_element(tp->tape, tp->index, position)) ||
+		    !cJSON_TapeGetValue(tp->tape, i, scratch)) {
+			return PARAM_MISSING;
+		}
+		*item = scratch;
+		return PARAM_OK;
+	}
+	if (params && (params->type & CJRPC2_TYPE_LAZY) && !(params = cjrpc2_params(params))) {
+		return PARAM_EPARSE;
+	}
+	if (!(*item = cjrpc2_array_item(params, position))) {
+		return PARAM_MISSING;
+	}
+
+	return PARAM_OK;
+}
+
+static enum cjrpc2_param_status cjrpc2_item_double(const cJSON *item, double *value)
+{
+	if (!cJSON_IsNumber(item)) {
+		return PARAM_WRONG_TYPE;
+	}
+
+	*value = cJSON_GetNumberValue(item);
+	return PARAM_OK;
+}
+
+static enum cjrpc2_param_status cjrpc2_item_int_range(const cJSON *item, int *value,
+						      const int min, const int max)
+{
+	int64_t ival;
+	double dval;
+
+	if (!cJSON_IsNumber(item)) {
+		return PARAM_WRONG_TYPE;
+	}
+
+	/* integers (exact for integer literals) are range checked without the floor() check */
+	if (cJSON_GetInt64Value(item, &ival)) {
+		if (ival < min || ival > max) {
+			return PARAM_OO_RANGE;
+		}
+		*value = (int)ival;
+		return PARAM_OK;
+	}
+
+	dval = cJSON_GetNumberValue(item);
+	if (dval < min || dval > max) {
+		return PARAM_OO_RANGE;
+	}
+
+	if (floor(dval) != dval) {
+		return PARAM_NUM_NOINT;
+	}
+
+	*value = (int)dval;
+	return PARAM_OK;
+}
+
+static enum cjrpc2_param_status cjrpc2_item_int64(const cJSON *item, int64_t *value)
+{
+	if (!cJSON_IsNumber(item)) {
+		return PARAM_WRONG_TYPE;
+	}
+	if (!cJSON_GetInt64Value(item, value)) {
+		return floor(item->valuedouble) != item->valuedouble ? PARAM_NUM_NOINT
+								      : PARAM_OO_RANGE;
+	}
+
+	return PARAM_OK;
+}
+
+static enum cjrpc2_param_status cjrpc2_item_uint64(const cJSON *item, uint64_t *value)
+{
+	if (!cJSON_IsNumber(item)) {
+		return PARAM_WRONG_TYPE;
+	}
+	if (!cJSON_GetUint64Value(item, value)) {
+		return floor(item->valuedouble) != item->valuedouble ? PARAM_NUM_NOINT
+								      : PARAM_OO_RANGE;
+	}
+
+	return PARAM_OK;
+}
+
+static enum cjrpc2_param_status cjrpc2_item_bool(const cJSON *item, bool *value)
+{
+	if (!cJSON_IsBool(item)) {
+		return PARAM_WRONG_TYPE;
+	}
+
+	*value = cJSON_IsTrue(item);
+	return PARAM_OK;
+}
+
+static enum cjrpc2_param_status cjrpc2_item_string(const cJSON *item, char **value)
+{
+	char *json_str;
+	size_t value_size;
+
+	if (!cJSON_IsString(item)) {
+		return PARAM_WRONG_TYPE;
+	}
+	json_str = cJSON_GetStringValue(item);
+	value_size = strlen(json_str) + 1;
+
+	if (!(*value = (char *)malloc(value_size))) {
+		return PARAM_NOMEM;
+	}
+
+	strncpy(*value, json_str, value_size);
+	return PARAM_OK;
+}
+
+static enum cjrpc2_param_status cjrpc2_param_double(const cJSON *params, const char *name,
+						    const struct cjrpc2_param_key *key,
+						    double *value)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON scratch, *p_item;
+
+	if (PARAM_OK != (pstat = cjrpc2_get_param_item(params, name, key, &scratch, &p_item))) {
+		return pstat;
+	}
+
+	return cjrpc2_item_double(p_item, value);
+}
+
+static enum cjrpc2_param_status cjrpc2_param_double_range(const cJSON *params, const char *name,
+							  const struct cjrpc2_param_key *key,
+							  double *value, const double min,
+							  const double max)
+{
+	enum cjrpc2_param_status pstat;
+	double dval;
+
+	if (PARAM_OK != (pstat = cjrpc2_param_double(params, name, key, &dval))) {
+		return pstat;
+	}
+
+	if (dval < min || dval > max) {
+		return PARAM_OO_RANGE;
+	}
+
+	*value = dval;
+	return PARAM_OK;
+}
+
+static enum cjrpc2_param_status cjrpc2_param_int_range(const cJSON *params, const char *name,
+						       const struct cjrpc2_param_key *key,
+						       int *value, const int min, const int max)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON scratch, *p_item;
+
+	if (PARAM_OK != (pstat = cjrpc2_get_param_item(params, name, key, &scratch, &p_item))) {
+		return pstat;
+	}
+
+	return cjrpc2_item_int_range(p_item, value, min, max);
+}
+
+static enum cjrpc2_param_status cjrpc2_param_int64(const cJSON *params, const char *name,
+						   const struct cjrpc2_param_key *key,
+						   int64_t *value)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON scratch, *p_item;
+
+	if (PARAM_OK != (pstat = cjrpc2_get_param_item(params, name, key, &scratch, &p_item))) {
+		return pstat;
+	}
+
+	return cjrpc2_item_int64(p_item, value);
+}
+
+static enum cjrpc2_param_status cjrpc2_param_uint64(const cJSON *params, const char *name,
+						    const struct cjrpc2_param_key *key,
+						    uint64_t *value)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON scratch, *p_item;
+
+	if (PARAM_OK != (pstat = cjrpc2_get_param_item(params, name, key, &scratch, &p_item))) {
+		return pstat;
+	}
+
+	return cjrpc2_item_uint64(p_item, value);
+}
+
+static enum cjrpc2_param_status cjrpc2_param_bool(const cJSON *params, const char *name,
+						  const struct cjrpc2_param_key *key, bool *value)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON scratch, *p_item;
+
+	if (PARAM_OK != (pstat = cjrpc2_get_param_item(params, name, key, &scratch, &p_item))) {
+		return pstat;
+	}
+
+	return cjrpc2_item_bool(p_item, value);
+}
+
+static enum cjrpc2_param_status cjrpc2_param_string(const cJSON *params, const char *name,
+						    const struct cjrpc2_param_key *key,
+						    char **value)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON scratch, *p_item;
+
+	if (PARAM_OK != (pstat = cjrpc2_get_param_item(params, name, key, &scratch, &p_item))) {
+		return pstat;
+	}
+
+	return cjrpc2_item_string(p_item, value);
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_double(const cJSON *params, const char *name,
+						 double *value)
+{
+	return cjrpc2_param_double(params, name, NULL, value);
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_double_range(const cJSON *params, const char *name,
+						       double *value, const double min,
+						       const double max)
+{
+	return cjrpc2_param_double_range(params, name, NULL, value, min, max);
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_int(const cJSON *params, const char *name, int *value)
+{
+	return cjrpc2_param_int_range(params, name, NULL, value, INT_MIN, INT_MAX);
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_int_range(const cJSON *params, const char *name,
+						    int *value, const int min, const int max)
+{
+	return cjrpc2_param_int_range(params, name, NULL, value, min, max);
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_int64(const cJSON *params, const char *name,
+						int64_t *value)
+{
+	return cjrpc2_param_int64(params, name, NULL, value);
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_uint64(const cJSON *params, const char *name,
+						 uint64_t *value)
+{
+	return cjrpc2_param_uint64(params, name, NULL, value);
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_bool(const cJSON *params, const char *name, bool *value)
+{
+	return cjrpc2_param_bool(params, name, NULL, value);
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_string(const cJSON *params, const char *name,
+						 char **value)
+{
+	return cjrpc2_param_string(params, name, NULL, value);
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_double_key(const cJSON *params,
+						     const struct cjrpc2_param_key *key,
+						     double *value)
+{
+	return key ? cjrpc2_param_double(params, NULL, key, value) : PARAM_MISSING;
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_double_range_key(const cJSON *params,
+							   const struct cjrpc2_param_key *key,
+							   double *value, const double min,
+							   const double max)
+{
+	return key ? cjrpc2_param_double_range(params, NULL, key, value, min, max) : PARAM_MISSING;
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_int_key(const cJSON *params,
+						  const struct cjrpc2_param_key *key, int *value)
+{
+	return key ? cjrpc2_param_int_range(params, NULL, key, value, INT_MIN, INT_MAX)
+		   : PARAM_MISSING;
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_int_range_key(const cJSON *params,
+							const struct cjrpc2_param_key *key,
+							int *value, const int min, const int max)
+{
+	return key ? cjrpc2_param_int_range(params, NULL, key, value, min, max) : PARAM_MISSING;
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_int64_key(const cJSON *params,
+						    const struct cjrpc2_param_key *key,
+						    int64_t *value)
+{
+	return key ? cjrpc2_param_int64(params, NULL, key, value) : PARAM_MISSING;
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_uint64_key(const cJSON *params,
+						     const struct cjrpc2_param_key *key,
+						     uint64_t *value)
+{
+	return key ? cjrpc2_param_uint64(params, NULL, key, value) : PARAM_MISSING;
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_bool_key(const cJSON *params,
+						   const struct cjrpc2_param_key *key, bool *value)
+{
+	return key ? cjrpc2_param_bool(params, NULL, key, value) : PARAM_MISSING;
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_string_key(const cJSON *params,
+						     const struct cjrpc2_param_key *key,
+						     char **value)
+{
+	return key ? cjrpc2_param_string(params, NULL, key, value) : PARAM_MISSING;
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_double_at(const cJSON *params, size_t position,
+						    double *value)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON scratch, *p_item;
+
+	if (PARAM_OK != (pstat = cjrpc2_get_param_item_at(params, position, &scratch, &p_item))) {
+		return pstat;
+	}
+
+	return cjrpc2_item_double(p_item, value);
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_double_range_at(const cJSON *params, size_t position,
+							  double *value, const double min,
+							  const double max)
+{
+	enum cjrpc2_param_status pstat;
+	double dval;
+
+	if (PARAM_OK != (pstat = cjrpc2_get_param_double_at(params, position, &dval))) {
+		return pstat;
+	}
+
+	if (dval < min || dval > max) {
+		return PARAM_OO_RANGE;
+	}
+
+	*value = dval;
 	return PARAM_OK;
 }
+
+enum cjrpc2_param_status cjrpc2_get_param_int_at(const cJSON *params, size_t position, int *value)
+{
+	return cjrpc2_get_param_int_range_at(params, position, value, INT_MIN, INT_MAX);
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_int_range_at(const cJSON *params, size_t position,
+						       int *value, const int min, const int max)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON scratch, *p_item;
+
+	if (PARAM_OK != (pstat = cjrpc2_get_param_item_at(params, position, &scratch, &p_item))) {
+		return pstat;
+	}
+
+	return cjrpc2_item_int_range(p_item, value, min, max);
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_int64_at(const cJSON *params, size_t position,
+						   int64_t *value)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON scratch, *p_item;
+
+	if (PARAM_OK != (pstat = cjrpc2_get_param_item_at(params, position, &scratch, &p_item))) {
+		return pstat;
+	}
+
+	return cjrpc2_item_int64(p_item, value);
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_uint64_at(const cJSON *params, size_t position,
+						    uint64_t *value)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON scratch, *p_item;
+
+	if (PARAM_OK != (pstat = cjrpc2_get_param_item_at(params, position, &scratch, &p_item))) {
+		return pstat;
+	}
+
+	return cjrpc2_item_uint64(p_item, value);
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_bool_at(const cJSON *params, size_t position,
+						  bool *value)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON scratch, *p_item;
+
+	if (PARAM_OK != (pstat = cjrpc2_get_param_item_at(params, position, &scratch, &p_item))) {
+		return pstat;
+	}
+
+	return cjrpc2_item_bool(p_item, value);
+}
+
+enum cjrpc2_param_status cjrpc2_get_param_string_at(const cJSON *params, size_t position,
+						    char **value)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON scratch, *p_item;
+
+	if (PARAM_OK != (pstat = cjrpc2_get_param_item_at(params, position, &scratch, &p_item))) {
+		return pstat;
+	}
+
+	return cjrpc2_item_string(p_item, value);
+}
+
+/* slots of the open addressed name table of cjrpc2_get_params(), at most half of them used */
+#define CJRPC2_PARAMS_SLOTS (2 * CJRPC2_PARAM_DESC_MAX)
+
+/* state of cjrpc2_get_params(), bit i of the masks stands for entry i of the table */
+struct cjrpc2_params_fill {
+	const struct cjrpc2_param_desc *desc;
+	size_t count;
+	void *base;
+	unsigned char slots[CJRPC2_PARAMS_SLOTS]; /* table entry + 1 per name hash, 0 if empty */
+	uint32_t hashes[CJRPC2_PARAM_DESC_MAX];	  /* case insensitive hash per table entry */
+	size_t lens[CJRPC2_PARAM_DESC_MAX];
+	uint64_t seen;	 /* parameter found in params */
+	uint64_t filled; /* value stored in base */
+	cJSON *failed;	 /* reason per name of a failed parameter */
+	bool nomem;
+};
+
+static const char *const cjrpc2_param_reasons[] = {
+	[PARAM_OK] = "ok",
+	[PARAM_MISSING] = "missing",
+	[PARAM_WRONG_TYPE] = "wrong type",
+	[PARAM_NUM_NOINT] = "not an integer",
+	[PARAM_OO_RANGE] = "out of range",
+	[PARAM_NOMEM] = "out of memory",
+	[PARAM_EPARSE] = "parse error",
+};
+
+/* add a failed parameter to the data of the error response */
+static void cjrpc2_params_fail(struct cjrpc2_params_fill *fill, const char *name,
+			       enum cjrpc2_param_status pstat)
+{
+	cJSON *reason;
+
+	if (!fill->failed && !(fill->failed = cJSON_CreateObject())) {
+		fill->nomem = true;
+		return;
+	}
+	if (!(reason = cJSON_CreateStringReference(cjrpc2_param_reasons[pstat]))) {
+		fill->nomem = true;
+		return;
+	}
+	if (!cJSON_AddItemToObject(fill->failed, name, reason)) {
+		cJSON_Delete(reason);
+		fill->nomem = true;
+	}
+}
+
+/* convert item to the type of table entry i and store it, nothing is stored on failure */
+static void cjrpc2_params_store(struct cjrpc2_params_fill *fill, size_t i, const cJSON *item)
+{
+	const struct cjrpc2_param_desc *d = &fill->desc[i];
+	enum cjrpc2_param_status pstat;
+	union {
+		double d;
+		int i;
+		int64_t l;
+		uint64_t u;
+		bool b;
+		char *s;
+	} v;
+	double num = 0;
+	size_t size;
+
+	switch (d->type) {
+	case CJRPC2_PARAM_DOUBLE:
+		pstat = cjrpc2_item_double(item, &v.d);
+		num = v.d;
+		size = sizeof(v.d);
+		break;
+	case CJRPC2_PARAM_INT:
+		pstat = cjrpc2_item_int_range(item, &v.i, INT_MIN, INT_MAX);
+		num = v.i;
+		size = sizeof(v.i);
+		break;
+	case CJRPC2_PARAM_INT64:
+		pstat = cjrpc2_item_int64(item, &v.l);
+		num = (double)v.l;
+		size = sizeof(v.l);
+		break;
+	case CJRPC2_PARAM_UINT64:
+		pstat = cjrpc2_item_uint64(item, &v.u);
+		num = (double)v.u;
+		size = sizeof(v.u);
+		break;
+	case CJRPC2_PARAM_BOOL:
+		pstat = cjrpc2_item_bool(item, &v.b);
+		size = sizeof(v.b);
+		break;
+	case CJRPC2_PARAM_STRING:
+		pstat = cjrpc2_item_string(item, &v.s);
+		size = sizeof(v.s);
+		break;
+	default:
+		pstat = PARAM_WRONG_TYPE;
+		size = 0;
+		break;
+	}
+
+	if (pstat == PARAM_OK && (d->flags & CJRPC2_PARAM_RANGE) && d->type != CJRPC2_PARAM_BOOL &&
+	    d->type != CJRPC2_PARAM_STRING && (num < d->min || num > d->max)) {
+		pstat = PARAM_OO_RANGE;
+	}
+	if (pstat != PARAM_OK) {
+		cjrpc2_params_fail(fill, d->name, pstat);
+		return;
+	}
+
+	memcpy((char *)fill->base + d->offset, &v, size);
+	fill->filled |= (uint64_t)1 << i;
+}
+
+/* store a member of params if the table has it, the first one of equal names counts */
+static void cjrpc2_params_member(struct cjrpc2_params_fill *fill, const char *name,
+				 const cJSON *item)
+{
+	uint32_t hash;
+	size_t i, s, len;
+
+	if (!name) {
+		return;
+	}
+	hash = cjrpc2_member_hash(name, false, &len);
+	for (s = hash & (CJRPC2_PARAMS_SLOTS - 1); fill->slots[s];
+	     s = (s + 1) & (CJRPC2_PARAMS_SLOTS - 1)) {
+		i = fill->slots[s] - 1u;
+		if (fill->hashes[i] == hash && fill->lens[i] == len &&
+		    !(fill->seen & ((uint64_t)1 << i)) && cjrpc2_member_equal(fill->desc[i].name, name)) {
+			fill->seen |= (uint64_t)1 << i;
+			cjrpc2_params_store(fill, i, item);
+			return;
+		}
+	}
+}
+
+/* store element n of positional params as table entry n */
+static void cjrpc2_params_element(struct cjrpc2_params_fill *fill, size_t n, const cJSON *item)
+{
+	fill->seen |= (uint64_t)1 << n;
+	cjrpc2_params_store(fill, n, item);
+}
+
+int cjrpc2_get_params(const cJSON *params, const struct cjrpc2_param_desc *desc, void *base,
+		      cJSON **resp)
+{
+	const struct cjrpc2_tape_params *tp;
+	struct cjrpc2_params_fill fill;
+	const cJSON *c;
+	cJSON scratch;
+	size_t i, n, end;
+
+	if (!desc || !base || !resp) {
+		errno = EINVAL;
+		return CJRPC2_RET_ERROR;
+	}
+
+	memset(&fill, 0, sizeof(struct cjrpc2_params_fill));
+	fill.desc = desc;
+	fill.base = base;
+	for (fill.count = 0; desc[fill.count].name; fill.count++) {
+		if (fill.count == CJRPC2_PARAM_DESC_MAX) {
+			*resp = cjrpc2_impl_resp_error(JSONRPC2_EINTERN, "internal error", NULL);
+			errno = EINVAL;
+			return CJRPC2_RET_ERROR;
+		}
+		/* hash the names once, so that every member of params takes a single probe */
+		fill.hashes[fill.count] = cjrpc2_member_hash(desc[fill.count].name, false,
+							     &fill.lens[fill.count]);
+		for (n = fill.hashes[fill.count] & (CJRPC2_PARAMS_SLOTS - 1); fill.slots[n];
+		     n = (n + 1) & (CJRPC2_PARAMS_SLOTS - 1)) {
+		}
+		fill.slots[n] = (unsigned char)(fill.count + 1);
+	}
+
+	/* one pass over the members (or elements, in table order) of params */
+	if (params && (params->type & CJRPC2_TYPE_TAPE)) {
+		tp = (const struct cjrpc2_tape_params *)params;
+		end = cJSON_TapeSkip(tp->tape, tp->index) - 1;
+		if (cJSON_TapeType(tp->tape->entries[tp->index]) == '{') {
+			for (i = tp->index + 1; i < end; i = cJSON_TapeSkip(tp->tape, i + 1)) {
+				if (cJSON_TapeGetValue(tp->tape, i + 1, &scratch)) {
+					cjrpc2_params_member(&fill,
+							     cJSON_TapeGetString(tp->tape, i, NULL),
+							     &scratch);
+				}
+			}
+		} else if (cJSON_TapeType(tp->tape->entries[tp->index]) == '[') {
+			for (i = tp->index + 1, n = 0; i < end && n < fill.count;
+			     i = cJSON_TapeSkip(tp->tape, i), n++) {
+				if (cJSON_TapeGetValue(tp->tape, i, &scratch)) {
+					cjrpc2_params_element(&fill, n, &scratch);
+				}
+			}
+		}
+	} else if (params && (params->type & CJRPC2_TYPE_LAZY) && !(params = cjrpc2_params(params))) {
+		/* answered with a parse error by the handler anyway */
+		for (i = 0; i < fill.count; i++) {
+			cjrpc2_params_fail(&fill, desc[i].name, PARAM_EPARSE);
+			fill.seen |= (uint64_t)1 << i;
+		}
+	} else if (cJSON_IsObject(params)) {
+		for (c = params->child; c; c = c->next) {
+			cjrpc2_params_member(&fill, c->string, c);
+		}
+	} else if (cJSON_IsArray(params)) {
+		for (c = params->child, n = 0; c && n < fill.count; c = c->next, n++) {
+			cjrpc2_params_element(&fill, n, c);
+		}
+	}
+
+	for (i = 0; i < fill.count; i++) {
+		if (!(fill.seen & ((uint64_t)1 << i)) && !(desc[i].flags & CJRPC2_PARAM_OPTIONAL)) {
+			cjrpc2_params_fail(&fill, desc[i].name, PARAM_MISSING);
+		}
+	}
+	if (!fill.failed && !fill.nomem) {
+		return CJRPC2_RET_SUCCESS;
+	}
+
+	/* don't leave strings of the valid parameters behind */
+	for (i = 0; i < fill.count; i++) {
+		if ((fill.filled & ((uint64_t)1 << i)) && desc[i].type == CJRPC2_PARAM_STRING) {
+			free(*(char **)((char *)base + desc[i].offset));
+			*(char **)((char *)base + desc[i].offset) = NULL;
+		}
+	}
+	if (!(*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, "invalid params", fill.failed))) {
+		cJSON_Delete(fill.failed);
+	}
+
+	return CJRPC2_RET_ERROR;
+}
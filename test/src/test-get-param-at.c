@@ -0,0 +1,249 @@
+/* SPDX-License-Identifier: MIT */
+
+#include <stdarg.h>
+
+#include "cJRPC2.h"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <cmocka.h>
+
+#define VALUE_INIT   42
+#define BULK_PARAMS  300
+
+/*******************************************************************************
+ * Test helpers
+ ******************************************************************************/
+/* reads every one of BULK_PARAMS positional params backwards, then one beyond */
+static int impl_bulk(const cJSON *params, cJSON **resp)
+{
+	size_t i;
+	int v, sum;
+
+	for (i = BULK_PARAMS, sum = 0; i-- > 0;) {
+		if (cjrpc2_get_param_int_at(params, i, &v) != PARAM_OK || v != (int)i) {
+			*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, "invalid params", NULL);
+			return CJRPC2_RET_ERROR;
+		}
+		sum += v;
+	}
+	if (cjrpc2_get_param_int_at(params, BULK_PARAMS, &v) != PARAM_MISSING) {
+		*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, "beyond", NULL);
+		return CJRPC2_RET_ERROR;
+	}
+	*resp = cJSON_CreateNumber(sum);
+
+	return CJRPC2_RET_SUCCESS;
+}
+
+/* reads an array it builds and edits, which must not be served from a stale index */
+static int impl_built(const cJSON *params, cJSON **resp)
+{
+	cJSON *array;
+	size_t i;
+	int v;
+
+	(void)params; /* unused */
+
+	array = cJSON_CreateArray();
+	for (i = 0; i < BULK_PARAMS; i++) {
+		cJSON_AddItemToArray(array, cJSON_CreateNumber((double)i));
+	}
+	if (cjrpc2_get_param_int_at(array, 38, &v) != PARAM_OK || v != 38) {
+		cJSON_Delete(array);
+		*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, "invalid params", NULL);
+		return CJRPC2_RET_ERROR;
+	}
+	cJSON_DeleteItemFromArray(array, 0);
+	v = VALUE_INIT;
+	cjrpc2_get_param_int_at(array, 38, &v);
+	cJSON_Delete(array);
+	*resp = cJSON_CreateNumber(v);
+
+	return CJRPC2_RET_SUCCESS;
+}
+
+static struct cjrpc2_method methods[] = {
+	{"bulk", &impl_bulk},
+	{"built", &impl_built},
+	{NULL, NULL},
+};
+
+/*******************************************************************************
+ * Test functions
+ ******************************************************************************/
+static void test_at_types(void **state)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON *params;
+	double dvalue;
+	int64_t value;
+	uint64_t uvalue;
+	bool bvalue;
+	char *str;
+	int ivalue;
+
+	(void)state; /* unused */
+
+	params = cJSON_Parse("[1.5,-3,true,\"str\",{\"a\":1}]");
+
+	pstat = cjrpc2_get_param_double_at(params, 0, &dvalue);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_true(dvalue == 1.5);
+	pstat = cjrpc2_get_param_double_range_at(params, 0, &dvalue, 2.0, 3.0);
+	assert_int_equal(pstat, PARAM_OO_RANGE);
+	pstat = cjrpc2_get_param_int_at(params, 0, &ivalue);
+	assert_int_equal(pstat, PARAM_NUM_NOINT);
+
+	pstat = cjrpc2_get_param_int_range_at(params, 1, &ivalue, -3, 0);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_int_equal(ivalue, -3);
+	pstat = cjrpc2_get_param_int64_at(params, 1, &value);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_true(value == -3);
+	pstat = cjrpc2_get_param_uint64_at(params, 1, &uvalue);
+	assert_int_equal(pstat, PARAM_OO_RANGE);
+
+	pstat = cjrpc2_get_param_bool_at(params, 2, &bvalue);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_true(bvalue);
+
+	pstat = cjrpc2_get_param_string_at(params, 3, &str);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_string_equal(str, "str");
+	free(str);
+
+	pstat = cjrpc2_get_param_string_at(params, 4, &str);
+	assert_int_equal(pstat, PARAM_WRONG_TYPE);
+
+	ivalue = VALUE_INIT;
+	pstat = cjrpc2_get_param_int_at(params, 5, &ivalue);
+	assert_int_equal(pstat, PARAM_MISSING);
+	assert_int_equal(ivalue, VALUE_INIT);
+
+	cJSON_Delete(params);
+}
+
+static void test_at_named(void **state)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON *params;
+	int value;
+
+	(void)state; /* unused */
+
+	/* named params have no positions */
+	params = cJSON_Parse("{\"a\":1}");
+	value = VALUE_INIT;
+	pstat = cjrpc2_get_param_int_at(params, 0, &value);
+	assert_int_equal(pstat, PARAM_MISSING);
+	assert_int_equal(value, VALUE_INIT);
+	cJSON_Delete(params);
+
+	pstat = cjrpc2_get_param_int_at(NULL, 0, &value);
+	assert_int_equal(pstat, PARAM_MISSING);
+	assert_int_equal(value, VALUE_INIT);
+}
+
+static void test_at_edited(void **state)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON *params, *dup;
+	int value;
+
+	(void)state; /* unused */
+
+	params = cJSON_Parse("[0,1,2]");
+	assert_int_equal(cJSON_GetArraySize(params), 3);
+
+	/* the element count follows every change to the array */
+	assert_true(cJSON_AddItemToArray(params, cJSON_CreateNumber(3)));
+	assert_true(cJSON_InsertItemInArray(params, 0, cJSON_CreateNumber(-1)));
+	assert_int_equal(cJSON_GetArraySize(params), 5);
+	cJSON_DeleteItemFromArray(params, 2);
+	assert_true(cJSON_ReplaceItemInArray(params, 3, cJSON_CreateNumber(4)));
+	assert_int_equal(cJSON_GetArraySize(params), 4);
+
+	pstat = cjrpc2_get_param_int_at(params, 3, &value);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_int_equal(value, 4);
+	value = VALUE_INIT;
+	pstat = cjrpc2_get_param_int_at(params, 4, &value);
+	assert_int_equal(pstat, PARAM_MISSING);
+	assert_int_equal(value, VALUE_INIT);
+
+	dup = cJSON_Duplicate(params, cJSON_True);
+	assert_int_equal(cJSON_GetArraySize(dup), 4);
+	cJSON_Delete(dup);
+
+	while (cJSON_GetArraySize(params)) {
+		cJSON_DeleteItemFromArray(params, 0);
+	}
+	assert_null(params->child);
+
+	cJSON_Delete(params);
+}
+
+static void test_at_bulk(void **state)
+{
+	static const unsigned int flags[] = {
+		0,
+		CJRPC2_FLAG_LAZY_PARAMS,
+		CJRPC2_FLAG_TAPE,
+		CJRPC2_FLAG_ARENA,
+	};
+	struct cjrpc2_handler *h;
+	char *req, *ret, expected[64];
+	cJSON *params;
+	size_t i;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+
+	params = cJSON_CreateArray();
+	for (i = 0; i < BULK_PARAMS; i++) {
+		cJSON_AddItemToArray(params, cJSON_CreateNumber((double)i));
+	}
+	req = cjrpc2_create_request_str("bulk", params, cJSON_CreateNumber(1));
+	assert_non_null(req);
+	sprintf(expected, "{\"jsonrpc\":\"2.0\",\"result\":%d,\"id\":1}",
+		BULK_PARAMS * (BULK_PARAMS - 1) / 2);
+
+	for (i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+		h->flags = flags[i];
+		ret = cjrpc2_handle_request(h, req);
+		assert_non_null(ret);
+		assert_string_equal(ret, expected);
+		free(ret);
+	}
+
+	free(req);
+
+	ret = cjrpc2_handle_request(h, "{\"jsonrpc\":\"2.0\",\"method\":\"built\",\"id\":1}");
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"result\":39,\"id\":1}");
+	free(ret);
+
+	cjrpc2_free_handler(h);
+}
+
+/*******************************************************************************
+ * Test main
+ ******************************************************************************/
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_at_types),
+		cmocka_unit_test(test_at_named),
+		cmocka_unit_test(test_at_edited),
+		cmocka_unit_test(test_at_bulk),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
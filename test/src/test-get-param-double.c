@@ -6,6 +6,8 @@
 
 #include <setjmp.h>
 #include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 #include <cmocka.h>
 
@@ -104,6 +106,54 @@ static void test_param_ok(void **state)
 	assert_float_equal(pvalue, value, 0);
 }
 
+static void test_param_parsed(void **state)
+{
+	static const char *numbers[] = {
+		"0",
+		"-0",
+		"13.37",
+		"0.3",
+		"123456789012345",
+		"1234567890123456789",
+		"9007199254740993",
+		"1e22",
+		"1e23",
+		"1.5e30",
+		"1e-22",
+		"1e-23",
+		"0.000001234",
+		"12.5E-3",
+		"1E+2",
+		"2.2250738585072014e-308",
+		"4.9e-324",
+		"1.7976931348623157e308",
+		"1e400",
+		"-1e-400",
+		"0.100000000000000000000000001",
+	};
+	enum cjrpc2_param_status pstat;
+	char json[128];
+	cJSON *params;
+	double value;
+	size_t i;
+
+	(void)state; /* unused */
+
+	for (i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++) {
+		sprintf(json, "{\"foo\":%s}", numbers[i]);
+		params = cJSON_Parse(json);
+		assert_non_null(params);
+
+		value = VALUE_INIT;
+		pstat = cjrpc2_get_param_double(params, "foo", &value);
+
+		cJSON_Delete(params);
+		assert_int_equal(pstat, PARAM_OK);
+		/* must be exactly the correctly rounded value */
+		assert_memory_equal(&value, &(double){strtod(numbers[i], NULL)}, sizeof(double));
+	}
+}
+
 /*******************************************************************************
  * Test main
  ******************************************************************************/
@@ -115,6 +165,7 @@ int main(void)
 		cmocka_unit_test(test_param_missing),
 		cmocka_unit_test(test_param_wrong_type),
 		cmocka_unit_test(test_param_ok),
+		cmocka_unit_test(test_param_parsed),
 	};
 
 	return cmocka_run_group_tests(tests, NULL, NULL);
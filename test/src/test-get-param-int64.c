@@ -0,0 +1,191 @@
+/* SPDX-License-Identifier: MIT */
+
+#include <stdarg.h>
+
+#include "cJRPC2.h"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#define VALUE_INIT 42
+
+/*******************************************************************************
+ * Test functions
+ ******************************************************************************/
+static void test_params_object_null(void **state)
+{
+	enum cjrpc2_param_status pstat;
+	int64_t value;
+
+	(void)state; /* unused */
+
+	value = VALUE_INIT;
+	pstat = cjrpc2_get_param_int64(NULL, "foo", &value);
+
+	assert_int_equal(pstat, PARAM_MISSING);
+	assert_true(value == VALUE_INIT);
+}
+
+static void test_param_wrong_type(void **state)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON *params;
+	int64_t value;
+
+	(void)state; /* unused */
+
+	params = cJSON_Parse("{\"foo\":\"1\"}");
+
+	value = VALUE_INIT;
+	pstat = cjrpc2_get_param_int64(params, "foo", &value);
+
+	cJSON_Delete(params);
+	assert_int_equal(pstat, PARAM_WRONG_TYPE);
+	assert_true(value == VALUE_INIT);
+}
+
+static void test_param_noint(void **state)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON *params;
+	int64_t value;
+	uint64_t uvalue;
+
+	(void)state; /* unused */
+
+	params = cJSON_Parse("{\"foo\":1.5}");
+
+	value = VALUE_INIT;
+	pstat = cjrpc2_get_param_int64(params, "foo", &value);
+	assert_int_equal(pstat, PARAM_NUM_NOINT);
+	assert_true(value == VALUE_INIT);
+
+	uvalue = VALUE_INIT;
+	pstat = cjrpc2_get_param_uint64(params, "foo", &uvalue);
+	assert_int_equal(pstat, PARAM_NUM_NOINT);
+	assert_true(uvalue == VALUE_INIT);
+
+	cJSON_Delete(params);
+}
+
+static void test_param_exact(void **state)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON *params;
+	int64_t value;
+	uint64_t uvalue;
+	char *str;
+
+	(void)state; /* unused */
+
+	/* none of these survive a round trip through double */
+	params = cJSON_Parse("{\"a\":9007199254740993,\"b\":-9223372036854775808,"
+			     "\"c\":9223372036854775807,\"d\":18446744073709551615}");
+	assert_non_null(params);
+
+	pstat = cjrpc2_get_param_int64(params, "a", &value);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_true(value == INT64_C(9007199254740993));
+
+	pstat = cjrpc2_get_param_int64(params, "b", &value);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_true(value == INT64_MIN);
+
+	pstat = cjrpc2_get_param_int64(params, "c", &value);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_true(value == INT64_MAX);
+
+	pstat = cjrpc2_get_param_uint64(params, "d", &uvalue);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_true(uvalue == UINT64_MAX);
+
+	/* and they are printed exactly again */
+	str = cJSON_PrintUnformatted(params);
+	assert_string_equal(str, "{\"a\":9007199254740993,\"b\":-9223372036854775808,"
+				 "\"c\":9223372036854775807,\"d\":18446744073709551615}");
+	cJSON_free(str);
+
+	cJSON_Delete(params);
+}
+
+static void test_param_oo_range(void **state)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON *params;
+	int64_t value;
+	uint64_t uvalue;
+	int ivalue;
+
+	(void)state; /* unused */
+
+	params = cJSON_Parse("{\"big\":18446744073709551615,\"huge\":1e30,\"neg\":-1}");
+	assert_non_null(params);
+
+	value = VALUE_INIT;
+	pstat = cjrpc2_get_param_int64(params, "big", &value);
+	assert_int_equal(pstat, PARAM_OO_RANGE);
+	pstat = cjrpc2_get_param_int64(params, "huge", &value);
+	assert_int_equal(pstat, PARAM_OO_RANGE);
+	assert_true(value == VALUE_INIT);
+
+	uvalue = VALUE_INIT;
+	pstat = cjrpc2_get_param_uint64(params, "neg", &uvalue);
+	assert_int_equal(pstat, PARAM_OO_RANGE);
+	assert_true(uvalue == VALUE_INIT);
+
+	ivalue = VALUE_INIT;
+	pstat = cjrpc2_get_param_int(params, "big", &ivalue);
+	assert_int_equal(pstat, PARAM_OO_RANGE);
+	pstat = cjrpc2_get_param_int_range(params, "neg", &ivalue, 0, 10);
+	assert_int_equal(pstat, PARAM_OO_RANGE);
+	assert_int_equal(ivalue, VALUE_INIT);
+
+	pstat = cjrpc2_get_param_int_range(params, "neg", &ivalue, -1, 10);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_int_equal(ivalue, -1);
+
+	cJSON_Delete(params);
+}
+
+static void test_param_created(void **state)
+{
+	enum cjrpc2_param_status pstat;
+	cJSON *params;
+	int64_t value;
+
+	(void)state; /* unused */
+
+	params = cJSON_CreateObject();
+	cJSON_AddNumberToObject(params, "double", 1e15);
+	cJSON_AddItemToObject(params, "int64", cJSON_CreateInt64(INT64_C(-9007199254740993)));
+
+	pstat = cjrpc2_get_param_int64(params, "double", &value);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_true(value == INT64_C(1000000000000000));
+
+	pstat = cjrpc2_get_param_int64(params, "int64", &value);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_true(value == INT64_C(-9007199254740993));
+
+	cJSON_Delete(params);
+}
+
+/*******************************************************************************
+ * Test main
+ ******************************************************************************/
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_params_object_null),
+		cmocka_unit_test(test_param_wrong_type),
+		cmocka_unit_test(test_param_noint),
+		cmocka_unit_test(test_param_exact),
+		cmocka_unit_test(test_param_oo_range),
+		cmocka_unit_test(test_param_created),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
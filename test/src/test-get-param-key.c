@@ -0,0 +1,160 @@
+/* SPDX-License-Identifier: MIT */
+
+#include <stdarg.h>
+
+#include "cJRPC2.h"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <cmocka.h>
+
+#define VALUE_INIT 42
+
+/*******************************************************************************
+ * Test functions
+ ******************************************************************************/
+static void test_key_null(void **state)
+{
+	struct cjrpc2_param_key key;
+	enum cjrpc2_param_status pstat;
+	int value;
+
+	(void)state; /* unused */
+
+	key = cjrpc2_param_key("foo");
+	assert_int_equal(key.len, 3);
+
+	value = VALUE_INIT;
+	pstat = cjrpc2_get_param_int_key(NULL, &key, &value);
+	assert_int_equal(pstat, PARAM_MISSING);
+	assert_int_equal(value, VALUE_INIT);
+
+	pstat = cjrpc2_get_param_int_key(NULL, NULL, &value);
+	assert_int_equal(pstat, PARAM_MISSING);
+	assert_int_equal(value, VALUE_INIT);
+}
+
+static void test_key_case_sensitive(void **state)
+{
+	struct cjrpc2_param_key key;
+	enum cjrpc2_param_status pstat;
+	cJSON *params;
+	int value;
+
+	(void)state; /* unused */
+
+	params = cJSON_Parse("{\"Foo\":1,\"foo\":2}");
+
+	key = cjrpc2_param_key("foo");
+	pstat = cjrpc2_get_param_int_key(params, &key, &value);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_int_equal(value, 2);
+
+	key = cjrpc2_param_key("FOO");
+	value = VALUE_INIT;
+	pstat = cjrpc2_get_param_int_key(params, &key, &value);
+	assert_int_equal(pstat, PARAM_MISSING);
+	assert_int_equal(value, VALUE_INIT);
+
+	/* names are still looked up case insensitive */
+	pstat = cjrpc2_get_param_int(params, "FOO", &value);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_int_equal(value, 1);
+
+	cJSON_Delete(params);
+}
+
+static void test_key_length(void **state)
+{
+	struct cjrpc2_param_key key;
+	enum cjrpc2_param_status pstat;
+	cJSON *params;
+	int value;
+
+	(void)state; /* unused */
+
+	params = cJSON_Parse("{\"foobar\":1,\"foo\":2}");
+
+	/* key names need not be terminated */
+	key.name = "foobar";
+	key.len = 3;
+	key.hash = cjrpc2_param_key("foo").hash;
+	pstat = cjrpc2_get_param_int_key(params, &key, &value);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_int_equal(value, 2);
+
+	key = cjrpc2_param_key("fo");
+	pstat = cjrpc2_get_param_int_key(params, &key, &value);
+	assert_int_equal(pstat, PARAM_MISSING);
+
+	cJSON_Delete(params);
+}
+
+static void test_key_types(void **state)
+{
+	struct cjrpc2_param_key key;
+	enum cjrpc2_param_status pstat;
+	cJSON *params;
+	double dvalue;
+	int64_t value;
+	uint64_t uvalue;
+	bool bvalue;
+	char *str;
+	int ivalue;
+
+	(void)state; /* unused */
+
+	params = cJSON_Parse("{\"d\":1.5,\"i\":-3,\"b\":true,\"s\":\"str\"}");
+
+	key = cjrpc2_param_key("d");
+	pstat = cjrpc2_get_param_double_key(params, &key, &dvalue);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_true(dvalue == 1.5);
+	pstat = cjrpc2_get_param_double_range_key(params, &key, &dvalue, 2.0, 3.0);
+	assert_int_equal(pstat, PARAM_OO_RANGE);
+	pstat = cjrpc2_get_param_int_key(params, &key, &ivalue);
+	assert_int_equal(pstat, PARAM_NUM_NOINT);
+
+	key = cjrpc2_param_key("i");
+	pstat = cjrpc2_get_param_int_range_key(params, &key, &ivalue, -3, 0);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_int_equal(ivalue, -3);
+	pstat = cjrpc2_get_param_int64_key(params, &key, &value);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_true(value == -3);
+	pstat = cjrpc2_get_param_uint64_key(params, &key, &uvalue);
+	assert_int_equal(pstat, PARAM_OO_RANGE);
+
+	key = cjrpc2_param_key("b");
+	pstat = cjrpc2_get_param_bool_key(params, &key, &bvalue);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_true(bvalue);
+	pstat = cjrpc2_get_param_string_key(params, &key, &str);
+	assert_int_equal(pstat, PARAM_WRONG_TYPE);
+
+	key = cjrpc2_param_key("s");
+	pstat = cjrpc2_get_param_string_key(params, &key, &str);
+	assert_int_equal(pstat, PARAM_OK);
+	assert_string_equal(str, "str");
+	free(str);
+
+	cJSON_Delete(params);
+}
+
+/*******************************************************************************
+ * Test main
+ ******************************************************************************/
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_key_null),
+		cmocka_unit_test(test_key_case_sensitive),
+		cmocka_unit_test(test_key_length),
+		cmocka_unit_test(test_key_types),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,219 @@
+/* SPDX-License-Identifier: MIT */
+
+#include <stdarg.h>
+
+#include "cJRPC2.h"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#define VALUE_INIT 42
+
+/*******************************************************************************
+ * Test helpers
+ ******************************************************************************/
+struct args {
+	double d;
+	int i;
+	int64_t l;
+	uint64_t u;
+	bool b;
+	char *s;
+};
+
+static const struct cjrpc2_param_desc desc[] = {
+	{"d", CJRPC2_PARAM_DOUBLE, offsetof(struct args, d), CJRPC2_PARAM_RANGE, -1.0, 1.0},
+	{"i", CJRPC2_PARAM_INT, offsetof(struct args, i), CJRPC2_PARAM_OPTIONAL, 0, 0},
+	{"l", CJRPC2_PARAM_INT64, offsetof(struct args, l), 0, 0, 0},
+	{"u", CJRPC2_PARAM_UINT64, offsetof(struct args, u), 0, 0, 0},
+	{"b", CJRPC2_PARAM_BOOL, offsetof(struct args, b), 0, 0, 0},
+	{"s", CJRPC2_PARAM_STRING, offsetof(struct args, s), 0, 0, 0},
+	{NULL, 0, 0, 0, 0, 0},
+};
+
+static int impl_args(const cJSON *params, cJSON **resp)
+{
+	struct args args;
+
+	args.i = VALUE_INIT;
+	if (cjrpc2_get_params(params, desc, &args, resp) != CJRPC2_RET_SUCCESS) {
+		return CJRPC2_RET_ERROR;
+	}
+	*resp = cJSON_CreateString(args.s);
+	free(args.s);
+
+	return CJRPC2_RET_SUCCESS;
+}
+
+static struct cjrpc2_method methods[] = {
+	{"args", &impl_args},
+	{NULL, NULL},
+};
+
+/*******************************************************************************
+ * Test functions
+ ******************************************************************************/
+static void test_params_ok(void **state)
+{
+	struct args args;
+	cJSON *params, *resp;
+	int ret;
+
+	(void)state; /* unused */
+
+	params = cJSON_Parse("{\"S\":\"str\",\"d\":0.5,\"l\":-3,\"x\":[],\"u\":18446744073709551615,"
+			     "\"b\":true,\"s\":\"second\"}");
+	assert_non_null(params);
+
+	memset(&args, 0, sizeof(args));
+	args.i = VALUE_INIT;
+	resp = NULL;
+	ret = cjrpc2_get_params(params, desc, &args, &resp);
+	assert_int_equal(ret, CJRPC2_RET_SUCCESS);
+	assert_null(resp);
+	assert_true(args.d == 0.5);
+	assert_int_equal(args.i, VALUE_INIT);
+	assert_true(args.l == -3);
+	assert_true(args.u == UINT64_MAX);
+	assert_true(args.b);
+	/* case insensitive, the first one counts */
+	assert_string_equal(args.s, "str");
+	free(args.s);
+
+	cJSON_Delete(params);
+}
+
+static void test_params_failed(void **state)
+{
+	struct args args;
+	cJSON *params, *resp;
+	char *str;
+	int ret;
+
+	(void)state; /* unused */
+
+	params = cJSON_Parse("{\"d\":2,\"i\":1.5,\"l\":\"3\",\"s\":\"str\"}");
+	assert_non_null(params);
+
+	memset(&args, 0, sizeof(args));
+	ret = cjrpc2_get_params(params, desc, &args, &resp);
+	assert_int_equal(ret, CJRPC2_RET_ERROR);
+	assert_non_null(resp);
+	/* the valid string isn't left behind */
+	assert_null(args.s);
+
+	str = cJSON_PrintUnformatted(resp);
+	assert_non_null(str);
+	assert_string_equal(str, "{\"code\":-32602,\"message\":\"invalid params\",\"data\":{"
+				 "\"d\":\"out of range\",\"i\":\"not an integer\","
+				 "\"l\":\"wrong type\",\"u\":\"missing\",\"b\":\"missing\"}}");
+	free(str);
+	cJSON_Delete(resp);
+
+	/* no params are missing params */
+	ret = cjrpc2_get_params(NULL, desc, &args, &resp);
+	assert_int_equal(ret, CJRPC2_RET_ERROR);
+	assert_int_equal(cJSON_GetArraySize(cJSON_GetObjectItem(resp, "data")), 5);
+	cJSON_Delete(resp);
+
+	cJSON_Delete(params);
+}
+
+static void test_params_positional(void **state)
+{
+	struct args args;
+	cJSON *params, *resp;
+	char *str;
+	int ret;
+
+	(void)state; /* unused */
+
+	params = cJSON_Parse("[-1,7,8,9,false,\"str\",\"ignored\"]");
+	assert_non_null(params);
+
+	memset(&args, 0, sizeof(args));
+	resp = NULL;
+	ret = cjrpc2_get_params(params, desc, &args, &resp);
+	assert_int_equal(ret, CJRPC2_RET_SUCCESS);
+	assert_true(args.d == -1.0);
+	assert_int_equal(args.i, 7);
+	assert_true(args.l == 8);
+	assert_true(args.u == 9);
+	assert_false(args.b);
+	assert_string_equal(args.s, "str");
+	free(args.s);
+	cJSON_Delete(params);
+
+	/* entries beyond the end are missing */
+	params = cJSON_Parse("[0]");
+	assert_non_null(params);
+	ret = cjrpc2_get_params(params, desc, &args, &resp);
+	assert_int_equal(ret, CJRPC2_RET_ERROR);
+	str = cJSON_PrintUnformatted(cJSON_GetObjectItem(resp, "data"));
+	assert_non_null(str);
+	assert_string_equal(str, "{\"l\":\"missing\",\"u\":\"missing\",\"b\":\"missing\","
+				 "\"s\":\"missing\"}");
+	free(str);
+	cJSON_Delete(resp);
+	cJSON_Delete(params);
+}
+
+static void test_params_handler(void **state)
+{
+	static const unsigned int flags[] = {0, CJRPC2_FLAG_LAZY_PARAMS, CJRPC2_FLAG_TAPE};
+	struct cjrpc2_handler *h;
+	char *ret;
+	size_t i;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+
+	for (i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+		h->flags = flags[i];
+		ret = cjrpc2_handle_request(h, "{\"jsonrpc\":\"2.0\",\"method\":\"args\",\"params\":"
+					       "{\"d\":0,\"l\":1,\"u\":2,\"b\":false,\"s\":\"\\u00e4\"},"
+					       "\"id\":1}");
+		assert_non_null(ret);
+		assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"result\":\"\xc3\xa4\",\"id\":1}");
+		free(ret);
+
+		ret = cjrpc2_handle_request(h, "{\"jsonrpc\":\"2.0\",\"method\":\"args\",\"params\":"
+					       "[0,1,2,3,true,\"\\u00e4\"],\"id\":1}");
+		assert_non_null(ret);
+		assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"result\":\"\xc3\xa4\",\"id\":1}");
+		free(ret);
+
+		ret = cjrpc2_handle_request(h, "{\"jsonrpc\":\"2.0\",\"method\":\"args\",\"params\":"
+					       "{\"d\":0,\"l\":1,\"b\":false},\"id\":2}");
+		assert_non_null(ret);
+		assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":-32602,"
+					 "\"message\":\"invalid params\",\"data\":{\"u\":\"missing\","
+					 "\"s\":\"missing\"}},\"id\":2}");
+		free(ret);
+	}
+
+	cjrpc2_free_handler(h);
+}
+
+/*******************************************************************************
+ * Test main
+ ******************************************************************************/
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_params_ok),
+		cmocka_unit_test(test_params_failed),
+		cmocka_unit_test(test_params_positional),
+		cmocka_unit_test(test_params_handler),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,1235 @@
+/* SPDX-License-Identifier: MIT */
+
+#include <pthread.h>
+#include <stdarg.h>
+
+#include "cJRPC2.h"
+#include "handler_static.h" /* generated from handler_static.methods */
+
+#include <errno.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#define METHOD_COUNT	    300
+#define STATIC_METHOD_COUNT 100
+#define RCU_READERS	    4
+#define RCU_ITERATIONS	    200
+#define BULK_PARAMS	    300
+
+/*******************************************************************************
+ * Test helpers
+ ******************************************************************************/
+int impl_index(const cJSON *params, cJSON **resp)
+{
+	*resp = cJSON_Duplicate(params, cJSON_True);
+
+	return CJRPC2_RET_SUCCESS;
+}
+
+static int impl_first(const cJSON *params, cJSON **resp)
+{
+	(void)params; /* unused */
+
+	*resp = cJSON_CreateString("first");
+
+	return CJRPC2_RET_SUCCESS;
+}
+
+static int impl_second(const cJSON *params, cJSON **resp)
+{
+	(void)params; /* unused */
+
+	*resp = cJSON_CreateString("second");
+
+	return CJRPC2_RET_SUCCESS;
+}
+
+static int impl_wildcard(const cJSON *params, cJSON **resp)
+{
+	(void)params; /* unused */
+
+	*resp = cJSON_CreateString("wildcard");
+
+	return CJRPC2_RET_SUCCESS;
+}
+
+static int impl_catchall(const cJSON *params, cJSON **resp)
+{
+	(void)params; /* unused */
+
+	*resp = cJSON_CreateString("catchall");
+
+	return CJRPC2_RET_SUCCESS;
+}
+
+static int impl_sum(const cJSON *params, cJSON **resp)
+{
+	double a, b;
+
+	if (cjrpc2_get_param_double(params, "a", &a) != PARAM_OK ||
+	    cjrpc2_get_param_double(params, "b", &b) != PARAM_OK) {
+		*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, "invalid params", NULL);
+		return CJRPC2_RET_ERROR;
+	}
+	*resp = cJSON_CreateNumber(a + b);
+
+	return CJRPC2_RET_SUCCESS;
+}
+
+static int impl_params(const cJSON *params, cJSON **resp)
+{
+	*resp = cJSON_Duplicate(cjrpc2_params(params), cJSON_True);
+
+	return CJRPC2_RET_SUCCESS;
+}
+
+/* sums the "samples" array of the params token by token, other members are skipped */
+static int impl_samples(const cJSON *params, cJSON **resp)
+{
+	cJSON_Cursor *cursor;
+	double sum = 0;
+	int token;
+
+	cursor = cjrpc2_params_cursor(params);
+	if (!cursor || cJSON_CursorNext(cursor) != cJSON_TokenBeginObject) {
+		goto invalid;
+	}
+	while ((token = cJSON_CursorNext(cursor)) == cJSON_TokenKey) {
+		if (strcmp(cursor->item.valuestring, "samples")) {
+			token = cJSON_CursorNext(cursor);
+			if ((token == cJSON_TokenBeginObject || token == cJSON_TokenBeginArray) &&
+			    cJSON_CursorSkip(cursor) == cJSON_TokenError) {
+				goto invalid;
+			}
+			continue;
+		}
+		if (cJSON_CursorNext(cursor) != cJSON_TokenBeginArray) {
+			goto invalid;
+		}
+		while ((token = cJSON_CursorNext(cursor)) == cJSON_TokenNumber) {
+			sum += cursor->item.valuedouble;
+		}
+		if (token != cJSON_TokenEndArray) {
+			goto invalid;
+		}
+	}
+	if (token != cJSON_TokenEndObject) {
+		goto invalid;
+	}
+	*resp = cJSON_CreateNumber(sum);
+
+	return CJRPC2_RET_SUCCESS;
+
+invalid:
+	*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, "invalid params", NULL);
+	return CJRPC2_RET_ERROR;
+}
+
+static char *call(struct cjrpc2_handler *h, const char *method, cJSON *params)
+{
+	char *req, *ret;
+
+	req = cjrpc2_create_request_str(method, params, cJSON_CreateNumber(1));
+	ret = cjrpc2_handle_request(h, req);
+	free(req);
+
+	return ret;
+}
+
+/* reads every one of BULK_PARAMS members */
+static int impl_bulk(const cJSON *params, cJSON **resp)
+{
+	struct cjrpc2_param_key key;
+	char name[16];
+	int i, v, sum;
+
+	for (i = sum = 0; i < BULK_PARAMS; i++) {
+		sprintf(name, "P%d", i);
+		if (cjrpc2_get_param_int(params, name, &v) != PARAM_OK) {
+			*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, name, NULL);
+			return CJRPC2_RET_ERROR;
+		}
+		sum += v;
+	}
+	/* first match wins, case insensitive */
+	if (cjrpc2_get_param_int(params, "DUP", &v) != PARAM_OK || v != 1 ||
+	    cjrpc2_get_param_int(params, "nope", &v) != PARAM_MISSING) {
+		*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, "dup", NULL);
+		return CJRPC2_RET_ERROR;
+	}
+	/* keys are case sensitive */
+	key = cjrpc2_param_key("Dup");
+	if (cjrpc2_get_param_int_key(params, &key, &v) != PARAM_OK || v != 2) {
+		*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, "Dup", NULL);
+		return CJRPC2_RET_ERROR;
+	}
+	key = cjrpc2_param_key("DUP");
+	if (cjrpc2_get_param_int_key(params, &key, &v) != PARAM_MISSING) {
+		*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, "DUP", NULL);
+		return CJRPC2_RET_ERROR;
+	}
+	*resp = cJSON_CreateNumber(sum);
+
+	return CJRPC2_RET_SUCCESS;
+}
+
+static cJSON *impl_kept;
+
+/* frees an item allocated before the request */
+static int impl_drop(const cJSON *params, cJSON **resp)
+{
+	(void)params; /* unused */
+
+	cJSON_Delete(impl_kept);
+	impl_kept = NULL;
+	*resp = cJSON_CreateString("dropped");
+
+	return CJRPC2_RET_SUCCESS;
+}
+
+static long hook_live;
+
+static void *hook_malloc(size_t size)
+{
+	void *p = malloc(size);
+
+	if (p) {
+		hook_live++;
+	}
+
+	return p;
+}
+
+static void hook_free(void *p)
+{
+	if (p) {
+		hook_live--;
+	}
+	free(p);
+}
+
+static struct cjrpc2_handler *impl_inner;
+
+/* handles a request on impl_inner from within a method */
+static int impl_nested(const cJSON *params, cJSON **resp)
+{
+	char *ret;
+
+	(void)params; /* unused */
+
+	ret = cjrpc2_handle_request(impl_inner,
+				    "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[\"in\"],\"id\":1}");
+	*resp = cJSON_CreateString(ret);
+	free(ret);
+
+	return CJRPC2_RET_SUCCESS;
+}
+
+static void *rcu_reader(void *arg)
+{
+	struct cjrpc2_handler *h = arg;
+	long errors = 0;
+	char *ret;
+	int i;
+
+	for (i = 0; i < RCU_ITERATIONS * 4; i++) {
+		ret = call(h, "dyn", NULL);
+		if (!ret || (!strstr(ret, "\"first\"") && !strstr(ret, "-32601"))) {
+			errors++;
+		}
+		free(ret);
+	}
+
+	return (void *)errors;
+}
+
+static void *arena_worker(void *arg)
+{
+	struct cjrpc2_handler *h = arg;
+	long errors = 0;
+	char *ret;
+	int i;
+
+	for (i = 0; i < RCU_ITERATIONS; i++) {
+		ret = call(h, "echo", cJSON_CreateString("shared"));
+		if (!ret || !strstr(ret, "\"shared\"")) {
+			errors++;
+		}
+		free(ret);
+	}
+
+	return (void *)errors;
+}
+
+/*******************************************************************************
+ * Test functions
+ ******************************************************************************/
+static void test_handler_many_methods(void **state)
+{
+	static struct cjrpc2_method methods[METHOD_COUNT + 1];
+	static char names[METHOD_COUNT][16];
+	struct cjrpc2_handler *h;
+	char expected[64];
+	char *ret;
+	int i;
+
+	(void)state; /* unused */
+
+	for (i = 0; i < METHOD_COUNT; i++) {
+		sprintf(names[i], "method.%d", i);
+		methods[i].name = names[i];
+		methods[i].func = &impl_index;
+	}
+	methods[METHOD_COUNT].name = NULL;
+	methods[METHOD_COUNT].func = NULL;
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+
+	for (i = 0; i < METHOD_COUNT; i++) {
+		ret = call(h, names[i], cJSON_CreateNumber(i));
+		assert_non_null(ret);
+		sprintf(expected, "{\"jsonrpc\":\"2.0\",\"result\":%d,\"id\":1}", i);
+		assert_string_equal(ret, expected);
+		free(ret);
+	}
+
+	cjrpc2_free_handler(h);
+}
+
+static void test_handler_method_not_found(void **state)
+{
+	static struct cjrpc2_method methods[] = {
+		{"foo", &impl_first},
+		{NULL, NULL},
+	};
+	struct cjrpc2_handler *h;
+	char *ret;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+
+	ret = call(h, "bar", NULL);
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":-32601,\"message\":"
+				 "\"method not found\"},\"id\":1}");
+	free(ret);
+
+	cjrpc2_free_handler(h);
+}
+
+static void test_handler_first_registration_wins(void **state)
+{
+	static struct cjrpc2_method first[] = {
+		{"foo", &impl_first},
+		{NULL, NULL},
+	};
+	static struct cjrpc2_method second[] = {
+		{"foo", &impl_second},
+		{NULL, NULL},
+	};
+	struct cjrpc2_handler *h;
+	char *ret;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler_m(3, first, NULL, second);
+	assert_non_null(h);
+
+	ret = call(h, "foo", NULL);
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"result\":\"first\",\"id\":1}");
+	free(ret);
+
+	cjrpc2_free_handler(h);
+}
+
+static void test_handler_mounts(void **state)
+{
+	static struct cjrpc2_method foo[] = {
+		{"1", &impl_first},
+		{"*", &impl_wildcard},
+		{NULL, NULL},
+	};
+	static struct cjrpc2_method bar[] = {
+		{"1", &impl_second},
+		{NULL, NULL},
+	};
+	static struct cjrpc2_method root[] = {
+		{"*", &impl_catchall},
+		{NULL, NULL},
+	};
+	static const struct cjrpc2_mount mounts[] = {
+		{"foo", foo},
+		{"bar.baz", bar},
+		{NULL, root},
+		{NULL, NULL},
+	};
+	static const struct {
+		const char *method;
+		const char *result;
+	} calls[] = {
+		{"foo.1", "first"},	 {"foo.2", "wildcard"},	   {"foo.x.y", "wildcard"},
+		{"bar.baz.1", "second"}, {"bar.baz.2", "catchall"}, {"1", "catchall"},
+		{"foo", "catchall"},	 {"foo.*", "wildcard"},
+	};
+	struct cjrpc2_handler *h;
+	char expected[64];
+	char *ret;
+	size_t i;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler_mounts(mounts);
+	assert_non_null(h);
+
+	for (i = 0; i < sizeof(calls) / sizeof(calls[0]); i++) {
+		ret = call(h, calls[i].method, NULL);
+		assert_non_null(ret);
+		sprintf(expected, "{\"jsonrpc\":\"2.0\",\"result\":\"%s\",\"id\":1}",
+			calls[i].result);
+		assert_string_equal(ret, expected);
+		free(ret);
+	}
+
+	cjrpc2_free_handler(h);
+}
+
+static void test_handler_static(void **state)
+{
+	struct cjrpc2_handler handler, *h;
+	char name[32], expected[64];
+	char *ret;
+	int i;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler_static(&handler, &cjrpc2_table_handler_static);
+	assert_ptr_equal(h, &handler);
+
+	for (i = 0; i < STATIC_METHOD_COUNT; i++) {
+		sprintf(name, "static.%d", i);
+		ret = call(h, name, cJSON_CreateNumber(i));
+		assert_non_null(ret);
+		sprintf(expected, "{\"jsonrpc\":\"2.0\",\"result\":%d,\"id\":1}", i);
+		assert_string_equal(ret, expected);
+		free(ret);
+	}
+
+	ret = call(h, "static.wild.card", cJSON_CreateNumber(-1));
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"result\":-1,\"id\":1}");
+	free(ret);
+
+	for (i = STATIC_METHOD_COUNT; i < 2 * STATIC_METHOD_COUNT; i++) {
+		sprintf(name, "static.%d", i);
+		ret = call(h, name, NULL);
+		assert_non_null(ret);
+		assert_non_null(strstr(ret, "-32601"));
+		free(ret);
+	}
+
+	cjrpc2_free_handler(h);
+}
+
+static void test_handler_register(void **state)
+{
+	static struct cjrpc2_method methods[] = {
+		{"foo", &impl_first},
+		{NULL, NULL},
+	};
+	static char names[METHOD_COUNT][16];
+	struct cjrpc2_handler *h;
+	char expected[64];
+	char *ret;
+	int i;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+
+	assert_int_equal(cjrpc2_register_method(h, "foo", &impl_second), -1);
+	assert_int_equal(errno, EEXIST);
+	assert_int_equal(cjrpc2_register_method(h, "bar", NULL), -1);
+	assert_int_equal(errno, EINVAL);
+	assert_int_equal(cjrpc2_unregister_method(h, "bar"), -1);
+	assert_int_equal(errno, ENOENT);
+
+	/* grow the table well beyond its initial size */
+	for (i = 0; i < METHOD_COUNT; i++) {
+		sprintf(names[i], "method.%d", i);
+		assert_int_equal(cjrpc2_register_method(h, names[i], &impl_index), 0);
+	}
+	for (i = 0; i < METHOD_COUNT; i++) {
+		ret = call(h, names[i], cJSON_CreateNumber(i));
+		assert_non_null(ret);
+		sprintf(expected, "{\"jsonrpc\":\"2.0\",\"result\":%d,\"id\":1}", i);
+		assert_string_equal(ret, expected);
+		free(ret);
+	}
+
+	assert_int_equal(cjrpc2_unregister_method(h, "foo"), 0);
+	ret = call(h, "foo", NULL);
+	assert_non_null(ret);
+	assert_non_null(strstr(ret, "-32601"));
+	free(ret);
+
+	assert_int_equal(cjrpc2_register_method(h, "method.*", &impl_wildcard), 0);
+	ret = call(h, "method.x", NULL);
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"result\":\"wildcard\",\"id\":1}");
+	free(ret);
+
+	cjrpc2_free_handler(h);
+}
+
+static void test_handler_register_static(void **state)
+{
+	struct cjrpc2_handler handler, *h;
+	char *ret;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler_static(&handler, &cjrpc2_table_handler_static);
+	assert_ptr_equal(h, &handler);
+
+	assert_int_equal(cjrpc2_register_method(h, "static.1", &impl_first), -1);
+	assert_int_equal(errno, EEXIST);
+	assert_int_equal(cjrpc2_unregister_method(h, "static.1"), -1);
+	assert_int_equal(errno, EPERM);
+
+	/* runtime methods are an overlay, static wildcards only apply to unknown names */
+	assert_int_equal(cjrpc2_register_method(h, "static.wild.x", &impl_first), 0);
+	ret = call(h, "static.wild.x", NULL);
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"result\":\"first\",\"id\":1}");
+	free(ret);
+
+	assert_int_equal(cjrpc2_unregister_method(h, "static.wild.x"), 0);
+	ret = call(h, "static.wild.x", cJSON_CreateNumber(7));
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"result\":7,\"id\":1}");
+	free(ret);
+
+	assert_int_equal(cjrpc2_register_method(h, "dyn", &impl_first), 0);
+	cjrpc2_free_handler(h);
+}
+
+static void test_handler_register_concurrent(void **state)
+{
+	static struct cjrpc2_method methods[] = {
+		{"foo", &impl_first},
+		{NULL, NULL},
+	};
+	struct cjrpc2_handler *h;
+	pthread_t readers[RCU_READERS];
+	void *errors;
+	int i;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+
+	for (i = 0; i < RCU_READERS; i++) {
+		assert_int_equal(pthread_create(&readers[i], NULL, &rcu_reader, h), 0);
+	}
+	for (i = 0; i < RCU_ITERATIONS; i++) {
+		assert_int_equal(cjrpc2_register_method(h, "dyn", &impl_first), 0);
+		assert_int_equal(cjrpc2_unregister_method(h, "dyn"), 0);
+	}
+	for (i = 0; i < RCU_READERS; i++) {
+		assert_int_equal(pthread_join(readers[i], &errors), 0);
+		assert_null(errors);
+	}
+
+	cjrpc2_free_handler(h);
+}
+
+static void test_handler_request_len(void **state)
+{
+	static struct cjrpc2_method methods[] = {
+		{"foo", &impl_index},
+		{NULL, NULL},
+	};
+	/* two back to back frames of equal length */
+	static const char frames[] = "{\"jsonrpc\":\"2.0\",\"method\":\"foo\",\"params\":[1],\"id\":1}"
+				     "{\"jsonrpc\":\"2.0\",\"method\":\"foo\",\"params\":\"x\",\"id\":2}";
+	struct cjrpc2_handler *h;
+	size_t len;
+	char *buf, *ret;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+
+	/* exact size copy without NULL termination, so reading beyond len is caught */
+	len = sizeof(frames) - 1;
+	buf = malloc(len);
+	assert_non_null(buf);
+	memcpy(buf, frames, len);
+
+	ret = cjrpc2_handle_request_len(h, buf, len / 2);
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"result\":[1],\"id\":1}");
+	free(ret);
+
+	ret = cjrpc2_handle_request_len(h, buf + len / 2, len - len / 2);
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"result\":\"x\",\"id\":2}");
+	free(ret);
+
+	/* truncated frame */
+	ret = cjrpc2_handle_request_len(h, buf, len / 2 - 1);
+	assert_non_null(ret);
+	assert_non_null(strstr(ret, "-32700"));
+	free(ret);
+
+	ret = cjrpc2_handle_request_len(h, buf, 0);
+	assert_non_null(ret);
+	assert_non_null(strstr(ret, "-32700"));
+	free(ret);
+
+	free(buf);
+	cjrpc2_free_handler(h);
+}
+
+static void test_handler_lazy(void **state)
+{
+	static struct cjrpc2_method methods[] = {
+		{"sum", &impl_sum},
+		{"params", &impl_params},
+		{"ignore", &impl_first},
+		{NULL, NULL},
+	};
+	static const char *requests[] = {
+		"{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":{\"a\":1,\"b\":2.5},\"id\":1}",
+		"{\"id\":\"x\",\"params\":{\"b\":1},\"method\":\"sum\",\"jsonrpc\":\"2.0\"}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"params\",\"params\":[1,{\"a\":[]},\"]\"],\"id\":null}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"params\",\"id\":[1]}",
+		" { \"jsonrpc\" : \"2.0\" , \"method\" : \"s\\u0075m\" , \"params\" : "
+		"{ \"a\" : -1e2 , \"b\" : 0.5 } , \"id\" : 3 } ",
+		"{\"JSONRPC\":\"2.0\",\"method\":\"sum\",\"method\":\"x\",\"params\":{\"a\":1,\"b\":1},"
+		"\"id\":4}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"unknown\",\"params\":{\"a\":[1,2,3]},\"id\":5}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":{\"a\":1,\"b\":2}}",
+		"{\"jsonrpc\":\"1.0\",\"method\":\"sum\",\"id\":6}",
+		"{\"jsonrpc\":\"2.0\",\"method\":7,\"id\":7}",
+		"{\"jsonrpc\":\"2.0\",\"id\":8}",
+		"{}",
+		"[1,2]",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":{\"a\":1,\"b\":2},\"id\":9",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":{\"a\":1 \"b\":2},\"id\":10}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"sum",
+		"{\"jsonrpc\" \"2.0\",\"id\":11}",
+		"{jsonrpc:\"2.0\"}",
+		"{\"jsonrpc\":\"2.0\",\"params\":[1 2],\"id\":12}",
+		"{\"jsonrpc\":\"2.0\",\"id\":13,}",
+		"[1,2",
+		"",
+	};
+	struct cjrpc2_handler *eager, *lazy;
+	char *ret, *expected;
+	size_t i;
+	int round;
+
+	(void)state; /* unused */
+
+	eager = cjrpc2_new_handler(methods);
+	assert_non_null(eager);
+	lazy = cjrpc2_new_handler(methods);
+	assert_non_null(lazy);
+	lazy->flags |= CJRPC2_FLAG_LAZY_PARAMS;
+
+	/* both modes have to answer well-formed and broken requests the same way */
+	for (round = 0; round < 2; round++) {
+		for (i = 0; i < sizeof(requests) / sizeof(requests[0]); i++) {
+			expected = cjrpc2_handle_request(eager, requests[i]);
+			assert_non_null(expected);
+			ret = cjrpc2_handle_request(lazy, requests[i]);
+			assert_non_null(ret);
+			assert_string_equal(ret, expected);
+			free(expected);
+			free(ret);
+		}
+		/* including the error offsets */
+		eager->flags |= CJRPC2_FLAG_ERROR_OFFSET;
+		lazy->flags |= CJRPC2_FLAG_ERROR_OFFSET;
+	}
+	lazy->flags &= ~CJRPC2_FLAG_ERROR_OFFSET;
+
+	/* invalid params are only noticed when they are read */
+	ret = cjrpc2_handle_request(lazy, "{\"jsonrpc\":\"2.0\",\"method\":\"ignore\","
+					  "\"params\":{\"a\":nope},\"id\":1}");
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"result\":\"first\",\"id\":1}");
+	free(ret);
+
+	ret = cjrpc2_handle_request(lazy, "{\"jsonrpc\":\"2.0\",\"method\":\"sum\","
+					  "\"params\":{\"a\":nope},\"id\":1}");
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":-32700,\"message\":"
+				 "\"parse error\"},\"id\":null}");
+	free(ret);
+
+	lazy->flags |= CJRPC2_FLAG_ERROR_OFFSET;
+	ret = cjrpc2_handle_request(lazy, "{\"jsonrpc\":\"2.0\",\"method\":\"sum\","
+					  "\"params\":{\"a\":nope},\"id\":1}");
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":-32700,\"message\":"
+				 "\"parse error\",\"data\":{\"offset\":46}},\"id\":null}");
+	free(ret);
+
+	ret = cjrpc2_handle_request(eager, "{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"id\":1 2}");
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":-32700,\"message\":"
+				 "\"parse error\",\"data\":{\"offset\":39}},\"id\":null}");
+	free(ret);
+
+	cjrpc2_free_handler(eager);
+	cjrpc2_free_handler(lazy);
+}
+
+static void test_handler_cursor(void **state)
+{
+	static struct cjrpc2_method methods[] = {
+		{"samples", &impl_samples},
+		{NULL, NULL},
+	};
+	struct cjrpc2_handler *h;
+	char *req, *ret;
+	size_t i, len;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+
+	/* no cursor without lazy params */
+	ret = cjrpc2_handle_request(h, "{\"jsonrpc\":\"2.0\",\"method\":\"samples\","
+				       "\"params\":{\"samples\":[1]},\"id\":1}");
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":-32602,\"message\":"
+				 "\"invalid params\"},\"id\":1}");
+	free(ret);
+
+	h->flags |= CJRPC2_FLAG_LAZY_PARAMS;
+	ret = cjrpc2_handle_request(h, "{\"jsonrpc\":\"2.0\",\"method\":\"samples\",\"params\":"
+				       "{\"skip\":{\"samples\":[100,[]]},\"samples\":[1, 2,3.5 ],"
+				       "\"x\":\"\\u00e4\"},\"id\":1}");
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"result\":6.5,\"id\":1}");
+	free(ret);
+
+	/* invalid params the cursor runs into are a parse error */
+	ret = cjrpc2_handle_request(h, "{\"jsonrpc\":\"2.0\",\"method\":\"samples\","
+				       "\"params\":{\"samples\":[1,nope]},\"id\":1}");
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":-32700,\"message\":"
+				 "\"parse error\"},\"id\":null}");
+	free(ret);
+
+	h->flags |= CJRPC2_FLAG_ERROR_OFFSET;
+	ret = cjrpc2_handle_request(h, "{\"jsonrpc\":\"2.0\",\"method\":\"samples\","
+				       "\"params\":{\"samples\":[1,nope]},\"id\":1}");
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":-32700,\"message\":"
+				 "\"parse error\",\"data\":{\"offset\":59}},\"id\":null}");
+	free(ret);
+
+	/* a long array, read in place */
+	req = (char *)malloc(BULK_PARAMS * 1000 * 2 + 100);
+	assert_non_null(req);
+	len = (size_t)sprintf(req, "{\"jsonrpc\":\"2.0\",\"method\":\"samples\",\"params\":"
+				   "{\"s\\u0061mples\":[");
+	for (i = 0; i < BULK_PARAMS * 1000; i++) {
+		req[len++] = '1';
+		req[len++] = ',';
+	}
+	len += (size_t)sprintf(req + len - 1, "]},\"id\":1}") - 1;
+	ret = cjrpc2_handle_request_insitu(h, req, len);
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"result\":300000,\"id\":1}");
+	free(ret);
+	free(req);
+
+	cjrpc2_free_handler(h);
+}
+
+static void test_handler_tape(void **state)
+{
+	static struct cjrpc2_method methods[] = {
+		{"sum", &impl_sum},
+		{"params", &impl_params},
+		{NULL, NULL},
+	};
+	static const char *requests[] = {
+		"{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":{\"a\":1,\"b\":2.5},\"id\":1}",
+		"{\"id\":\"x\",\"params\":{\"B\":1,\"b\":2,\"A\":3},\"method\":\"sum\",\"jsonrpc\":\"2.0\"}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"params\",\"params\":[1,{\"a\":[]},\"\\u00e4\"],"
+		"\"id\":{\"x\":[null,true,false,-0.5,18446744073709551615]}}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"params\",\"id\":[1]}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":{\"a\":\"1\",\"b\":2},\"id\":2}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":{\"a\":1,\"b\":2}}",
+		"{\"jsonrpc\":\"1.0\",\"method\":\"sum\",\"id\":6}",
+		"{\"jsonrpc\":\"2.0\",\"method\":7,\"id\":7}",
+		"\"2.0\"",
+		"[1,2]",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":{\"a\":1 \"b\":2},\"id\":10}",
+		"",
+	};
+	struct cjrpc2_handler *tree, *tape;
+	char *ret, *expected;
+	size_t i;
+
+	(void)state; /* unused */
+
+	tree = cjrpc2_new_handler(methods);
+	assert_non_null(tree);
+	tree->flags |= CJRPC2_FLAG_ERROR_OFFSET;
+	tape = cjrpc2_new_handler(methods);
+	assert_non_null(tape);
+	tape->flags |= CJRPC2_FLAG_TAPE | CJRPC2_FLAG_ERROR_OFFSET;
+
+	for (i = 0; i < sizeof(requests) / sizeof(requests[0]); i++) {
+		expected = cjrpc2_handle_request(tree, requests[i]);
+		assert_non_null(expected);
+		ret = cjrpc2_handle_request(tape, requests[i]);
+		assert_non_null(ret);
+		assert_string_equal(ret, expected);
+		free(expected);
+		free(ret);
+	}
+
+	cjrpc2_free_handler(tree);
+	cjrpc2_free_handler(tape);
+}
+
+static void test_handler_insitu(void **state)
+{
+	static struct cjrpc2_method methods[] = {
+		{"echo", &impl_params},
+		{"sum", &impl_sum},
+		{NULL, NULL},
+	};
+	static const char *requests[] = {
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":{\"k\\\"ey\":\"a\\nb\\\\c\"},\"id\":1}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"e\\u0063ho\",\"params\":[\"\\u00e4\\u20ac\\ud83d\\ude00\",\"\"],"
+		"\"id\":\"\\/x\"}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":{\"a\":[{\"\\t\":\"\\u0000x\"}]},\"id\":2}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":{\"\\u0061\":1,\"b\":2},\"id\":3}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":{\"a\":\"\\x\"},\"id\":4}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":{\"a\":\"b\\\"},\"id\":5}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[\"\\ud83d\"],\"id\":6}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":{\"a\":1}",
+	};
+	struct cjrpc2_handler *h;
+	char *buf, *ret, *expected;
+	size_t i, len;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+
+	/* answers are the same as for copied strings, both eager and lazy */
+	for (h->flags = 0; h->flags <= CJRPC2_FLAG_LAZY_PARAMS; h->flags += CJRPC2_FLAG_LAZY_PARAMS) {
+		for (i = 0; i < sizeof(requests) / sizeof(requests[0]); i++) {
+			expected = cjrpc2_handle_request(h, requests[i]);
+			assert_non_null(expected);
+
+			/* exact size copy without NULL termination */
+			len = strlen(requests[i]);
+			buf = malloc(len);
+			assert_non_null(buf);
+			memcpy(buf, requests[i], len);
+			ret = cjrpc2_handle_request_insitu(h, buf, len);
+			free(buf);
+
+			assert_non_null(ret);
+			assert_string_equal(ret, expected);
+			free(expected);
+			free(ret);
+		}
+	}
+
+	cjrpc2_free_handler(h);
+}
+
+static void test_handler_arena(void **state)
+{
+	static struct cjrpc2_method methods[] = {
+		{"echo", &impl_params},
+		{"sum", &impl_sum},
+		{"drop", &impl_drop},
+		{NULL, NULL},
+	};
+	static const char *requests[] = {
+		"{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":{\"a\":1,\"b\":2.5},\"id\":1}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[\"a\\nb\",{\"c\":null}],\"id\":\"x\"}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":{\"a\":1,\"b\":2}}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"unknown\",\"id\":2}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":{\"a\":1 \"b\":2},\"id\":3}",
+		"[1,2]",
+	};
+	cJSON_Hooks global_hooks = {&hook_malloc, &hook_free};
+	pthread_t threads[RCU_READERS];
+	struct cjrpc2_handler *plain, *h;
+	char *big, *ret, *expected;
+	void *errors;
+	size_t i, len;
+	int round;
+
+	(void)state; /* unused */
+
+	plain = cjrpc2_new_handler(methods);
+	assert_non_null(plain);
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+
+	/* same answers as without arena, eager and lazy, with the arena reused */
+	for (round = 0; round < 4; round++) {
+		plain->flags = round % 2 ? CJRPC2_FLAG_LAZY_PARAMS : 0;
+		h->flags = plain->flags | CJRPC2_FLAG_ARENA;
+		for (i = 0; i < sizeof(requests) / sizeof(requests[0]); i++) {
+			expected = cjrpc2_handle_request(plain, requests[i]);
+			assert_non_null(expected);
+			ret = cjrpc2_handle_request(h, requests[i]);
+			assert_non_null(ret);
+			assert_string_equal(ret, expected);
+			free(expected);
+			free(ret);
+			assert_non_null(h->arena);
+			assert_null(h->arena->next);
+			assert_int_equal(h->arena_busy, 0);
+		}
+	}
+
+	/* a request outgrowing the arena leaves a single chunk large enough for it */
+	len = 10000;
+	big = malloc(len + 100);
+	assert_non_null(big);
+	strcpy(big, "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[");
+	for (i = strlen(big); i < len; i += 2) {
+		memcpy(&big[i], "1,", 2);
+	}
+	strcpy(&big[i], "1],\"id\":1}");
+	expected = cjrpc2_handle_request(plain, big);
+	assert_non_null(expected);
+	ret = cjrpc2_handle_request(h, big);
+	assert_non_null(ret);
+	assert_string_equal(ret, expected);
+	free(expected);
+	free(ret);
+	assert_non_null(h->arena);
+	assert_null(h->arena->next);
+	assert_true(h->arena->size > len);
+	free(big);
+
+	/* memory allocated before the request is still freed */
+	impl_kept = cJSON_CreateArray();
+	assert_non_null(impl_kept);
+	assert_non_null(cJSON_AddStringToObject(impl_kept, "a", "b"));
+	ret = cjrpc2_handle_request(h, "{\"jsonrpc\":\"2.0\",\"method\":\"drop\",\"id\":1}");
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"result\":\"dropped\",\"id\":1}");
+	free(ret);
+	assert_null(impl_kept);
+
+	/* also when it came from the cJSON_InitHooks() allocator */
+	cJSON_InitHooks(&global_hooks);
+	hook_live = 0;
+	impl_kept = cJSON_CreateArray();
+	assert_non_null(impl_kept);
+	ret = cjrpc2_handle_request(h, "{\"jsonrpc\":\"2.0\",\"method\":\"drop\",\"id\":1}");
+	assert_non_null(ret);
+	hook_free(ret);
+	assert_int_equal(hook_live, 0);
+	cJSON_InitHooks(NULL);
+
+	/* concurrent requests fall back to regular allocations while the arena is busy */
+	for (i = 0; i < RCU_READERS; i++) {
+		assert_int_equal(pthread_create(&threads[i], NULL, &arena_worker, h), 0);
+	}
+	for (i = 0; i < RCU_READERS; i++) {
+		assert_int_equal(pthread_join(threads[i], &errors), 0);
+		assert_null(errors);
+	}
+	assert_int_equal(h->arena_busy, 0);
+
+	cjrpc2_free_handler(plain);
+	cjrpc2_free_handler(h);
+}
+
+static void test_handler_hooks(void **state)
+{
+	static struct cjrpc2_method methods[] = {
+		{"echo", &impl_params},
+		{"sum", &impl_sum},
+		{"nested", &impl_nested},
+		{NULL, NULL},
+	};
+	static const char *requests[] = {
+		"{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":{\"a\":1,\"b\":2.5},\"id\":1}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[\"a\\nb\",{\"c\":[]}],\"id\":\"x\"}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":{\"a\":1,\"b\":2}}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"nested\",\"id\":2}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":{\"a\":1 \"b\":2},\"id\":3}",
+	};
+	cJSON_ThreadHooks thread_hooks = {&hook_malloc, &hook_free, NULL};
+	struct cjrpc2_handler *plain, *h;
+	char *ret, *expected;
+	unsigned int flags;
+	cJSON *item;
+	size_t i;
+
+	(void)state; /* unused */
+
+	plain = cjrpc2_new_handler(methods);
+	assert_non_null(plain);
+	impl_inner = cjrpc2_new_handler(methods);
+	assert_non_null(impl_inner);
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+	h->hooks.malloc_fn = &hook_malloc;
+	h->hooks.free_fn = &hook_free;
+
+	/* everything of a request, including the response string, comes from the handler's hooks */
+	for (flags = 0; flags <= (CJRPC2_FLAG_LAZY_PARAMS | CJRPC2_FLAG_ARENA); flags++) {
+		plain->flags = h->flags = flags;
+		for (i = 0; i < sizeof(requests) / sizeof(requests[0]); i++) {
+			expected = cjrpc2_handle_request(plain, requests[i]);
+			assert_non_null(expected);
+			hook_live = h->arena ? 1 : 0;
+			ret = cjrpc2_handle_request(h, requests[i]);
+			assert_non_null(ret);
+			assert_string_equal(ret, expected);
+			assert_true(hook_live > (h->arena ? 1 : 0));
+			hook_free(ret);
+			assert_int_equal(hook_live, h->arena ? 1 : 0);
+			free(expected);
+		}
+	}
+
+	hook_live = 1;
+	cjrpc2_free_handler(h);
+	assert_int_equal(hook_live, 0);
+
+	/* a handler without hooks uses the thread hooks of the application and leaves them installed */
+	cJSON_InitThreadHooks(&thread_hooks);
+	for (flags = 0; flags <= CJRPC2_FLAG_ARENA; flags += CJRPC2_FLAG_ARENA) {
+		plain->flags = flags;
+		ret = cjrpc2_handle_request(plain, requests[1]);
+		assert_non_null(ret);
+		assert_int_equal(hook_live, 1);
+		hook_free(ret);
+		item = cJSON_CreateArray();
+		assert_int_equal(hook_live, 1);
+		cJSON_Delete(item);
+		assert_int_equal(hook_live, 0);
+	}
+	cJSON_InitThreadHooks(NULL);
+
+	cjrpc2_free_handler(impl_inner);
+	cjrpc2_free_handler(plain);
+}
+
+/* reads members of a large object it builds and changes itself */
+static int impl_edit(const cJSON *params, cJSON **resp)
+{
+	char name[16];
+	cJSON *o;
+	int i, v;
+
+	(void)params; /* unused */
+
+	o = cJSON_CreateObject();
+	for (i = 0; i < 20; i++) {
+		sprintf(name, "k%d", i);
+		cJSON_AddNumberToObject(o, name, i);
+	}
+	if (cjrpc2_get_param_int(o, "k0", &v) != PARAM_OK || v != 0) {
+		*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, "k0", NULL);
+		goto exit_error;
+	}
+	cJSON_AddNumberToObject(o, "k20", 20);
+	cJSON_DeleteItemFromObject(o, "k7");
+	if (cjrpc2_get_param_int(o, "k20", &v) != PARAM_OK || v != 20 ||
+	    cjrpc2_get_param_int(o, "k7", &v) != PARAM_MISSING) {
+		*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, "stale", NULL);
+		goto exit_error;
+	}
+	cJSON_Delete(o);
+	*resp = cJSON_CreateString("ok");
+
+	return CJRPC2_RET_SUCCESS;
+
+exit_error:
+	cJSON_Delete(o);
+	return CJRPC2_RET_ERROR;
+}
+
+static void test_handler_many_params(void **state)
+{
+	static struct cjrpc2_method methods[] = {
+		{"bulk", &impl_bulk},
+		{"edit", &impl_edit},
+		{NULL, NULL},
+	};
+	static const unsigned int flags[] = {
+		0,
+		CJRPC2_FLAG_LAZY_PARAMS,
+		CJRPC2_FLAG_TAPE,
+		CJRPC2_FLAG_TAPE | CJRPC2_FLAG_ARENA,
+	};
+	struct cjrpc2_handler *h;
+	cJSON *params;
+	char name[16], *ret;
+	size_t f;
+	int i, sum;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+
+	for (i = sum = 0; i < BULK_PARAMS; i++) {
+		sum += i;
+	}
+	for (f = 0; f < sizeof(flags) / sizeof(flags[0]); f++) {
+		h->flags = flags[f];
+		params = cJSON_CreateObject();
+		assert_non_null(params);
+		assert_non_null(cJSON_AddNumberToObject(params, "dup", 1));
+		for (i = 0; i < BULK_PARAMS; i++) {
+			sprintf(name, "p%d", i);
+			assert_non_null(cJSON_AddNumberToObject(params, name, i));
+		}
+		assert_non_null(cJSON_AddNumberToObject(params, "Dup", 2));
+
+		ret = call(h, "bulk", params);
+		assert_non_null(ret);
+		sprintf(name, "%d", sum);
+		assert_non_null(strstr(ret, name));
+		free(ret);
+
+		/* only the params are indexed, objects of the method may change between lookups */
+		ret = cjrpc2_handle_request(h, "{\"jsonrpc\":\"2.0\",\"method\":\"edit\",\"id\":1}");
+		assert_non_null(ret);
+		assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"result\":\"ok\",\"id\":1}");
+		free(ret);
+	}
+
+	cjrpc2_free_handler(h);
+}
+
+static void test_handler_long_strings(void **state)
+{
+	static struct cjrpc2_method methods[] = {
+		{"echo", &impl_index},
+		{NULL, NULL},
+	};
+	struct cjrpc2_handler *h;
+	char str[128], req[256], expected[256];
+	char *ret;
+	size_t len, esc;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+
+	/*
+	 * escapes and whitespace at every position relative to the vector sizes of the scanners, the
+	 * escapes are printed back just like they were parsed
+	 */
+	for (len = 0; len < 100; len += 3) {
+		for (esc = 0; esc <= len; esc++) {
+			memset(str, 'x', len);
+			str[len] = '\0';
+			if (esc + 6 < len && esc % 2) {
+				memcpy(&str[esc], "\\u001f", 6);
+			} else if (esc + 1 < len) {
+				memcpy(&str[esc], "\\\"", 2);
+			}
+			sprintf(req, "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":%*s\"%s\",\"id\":1}",
+				(int)esc, "", str);
+			ret = cjrpc2_handle_request(h, req);
+			assert_non_null(ret);
+			sprintf(expected, "{\"jsonrpc\":\"2.0\",\"result\":\"%s\",\"id\":1}", str);
+			assert_string_equal(ret, expected);
+			free(ret);
+		}
+	}
+
+	cjrpc2_free_handler(h);
+}
+
+static void test_handler_numbers(void **state)
+{
+	static struct cjrpc2_method methods[] = {
+		{"echo", &impl_index},
+		{NULL, NULL},
+	};
+	struct cjrpc2_handler *h;
+	char *ret;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+
+	/*
+	 * numbers are printed with the shortest representation that reads back exactly, integer
+	 * literals are kept exactly
+	 */
+	ret = cjrpc2_handle_request(h, "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":["
+				       "0.30000000000000004,0.1,1e21,1e15,999999999999999,5e-324,-0,"
+				       "-1.5,100,0.0001,0.00001,123456789012345678,"
+				       "1.7976931348623157e308],\"id\":1}");
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"result\":[0.30000000000000004,0.1,1e+21,"
+				 "1e+15,999999999999999,5e-324,-0,-1.5,100,0.0001,1e-05,"
+				 "123456789012345678,1.7976931348623157e+308],\"id\":1}");
+	free(ret);
+
+	cjrpc2_free_handler(h);
+}
+
+/*******************************************************************************
+ * Test main
+ ******************************************************************************/
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_handler_many_methods),
+		cmocka_unit_test(test_handler_method_not_found),
+		cmocka_unit_test(test_handler_first_registration_wins),
+		cmocka_unit_test(test_handler_mounts),
+		cmocka_unit_test(test_handler_static),
+		cmocka_unit_test(test_handler_register),
+		cmocka_unit_test(test_handler_register_static),
+		cmocka_unit_test(test_handler_register_concurrent),
+		cmocka_unit_test(test_handler_request_len),
+		cmocka_unit_test(test_handler_lazy),
+		cmocka_unit_test(test_handler_cursor),
+		cmocka_unit_test(test_handler_tape),
+		cmocka_unit_test(test_handler_insitu),
+		cmocka_unit_test(test_handler_arena),
+		cmocka_unit_test(test_handler_hooks),
+		cmocka_unit_test(test_handler_many_params),
+		cmocka_unit_test(test_handler_long_strings),
+		cmocka_unit_test(test_handler_numbers),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
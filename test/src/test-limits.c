@@ -0,0 +1,247 @@
+/* SPDX-License-Identifier: MIT */
+
+#include <stdarg.h>
+
+#include "cJRPC2.h"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#define LIMIT_ERROR                                                                                \
+	"{\"jsonrpc\":\"2.0\",\"error\":{\"code\":-32600,\"message\":\"limit exceeded\"},"        \
+	"\"id\":null}"
+
+/*******************************************************************************
+ * Test helpers
+ ******************************************************************************/
+static int impl_echo(const cJSON *params, cJSON **resp)
+{
+	*resp = cJSON_Duplicate(cjrpc2_params(params), cJSON_True);
+
+	return CJRPC2_RET_SUCCESS;
+}
+
+/* reads the params token by token */
+static int impl_walk(const cJSON *params, cJSON **resp)
+{
+	cJSON_Cursor *cursor;
+	int token;
+
+	cursor = cjrpc2_params_cursor(params);
+	if (!cursor) {
+		*resp = cjrpc2_impl_resp_error(JSONRPC2_EIPARAM, "invalid params", NULL);
+		return CJRPC2_RET_ERROR;
+	}
+	do {
+		token = cJSON_CursorNext(cursor);
+	} while (token != cJSON_TokenEnd && token != cJSON_TokenError);
+	*resp = cJSON_CreateBool(token == cJSON_TokenEnd);
+
+	return CJRPC2_RET_SUCCESS;
+}
+
+static struct cjrpc2_method methods[] = {
+	{"echo", &impl_echo},
+	{"walk", &impl_walk},
+	{NULL, NULL},
+};
+
+/*******************************************************************************
+ * Test functions
+ ******************************************************************************/
+static void test_limits_cjson(void **state)
+{
+	cJSON_Limits limits;
+	cJSON *item;
+
+	(void)state; /* unused */
+
+	memset(&limits, 0, sizeof(cJSON_Limits));
+	limits.max_depth = 2;
+	limits.max_elements = 2;
+	limits.max_string = 3;
+	cJSON_InitThreadLimits(&limits);
+
+	item = cJSON_Parse("[[1,2],\"abc\"]");
+	assert_non_null(item);
+	cJSON_Delete(item);
+
+	assert_null(cJSON_Parse("[[[]]]"));
+	assert_true(cJSON_GetErrorLimit());
+	assert_null(cJSON_Parse("[1,2,3]"));
+	assert_true(cJSON_GetErrorLimit());
+	assert_null(cJSON_Parse("{\"abcd\":1}"));
+	assert_true(cJSON_GetErrorLimit());
+	/* a \u escape counts as five bytes */
+	assert_null(cJSON_Parse("\"\\u00e4\""));
+	assert_true(cJSON_GetErrorLimit());
+	assert_null(cJSON_Parse("[1,]"));
+	assert_false(cJSON_GetErrorLimit());
+
+	cJSON_InitThreadLimits(NULL);
+	item = cJSON_Parse("[[[1,2,3]],\"abcd\"]");
+	assert_non_null(item);
+	cJSON_Delete(item);
+}
+
+static void test_limits_handler(void **state)
+{
+	static const unsigned int flags[] = {
+		0,
+		CJRPC2_FLAG_LAZY_PARAMS,
+		CJRPC2_FLAG_TAPE,
+		CJRPC2_FLAG_ARENA,
+	};
+	static const char *refused[] = {
+		/* too long */
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[1],                          "
+		"                        \"id\":1}",
+		/* too deep, also when params are parsed on their own */
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[[[[1]]]],\"id\":1}",
+		/* too many members */
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5},"
+		"\"id\":1}",
+		/* too many elements */
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[1,2,3,4],\"id\":1}",
+		/* too long a string */
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[\"abcdefghi\"],\"id\":1}",
+	};
+	static const char *accepted =
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[[1],\"abcdefgh\",3],\"id\":1}";
+	struct cjrpc2_handler *h;
+	cJSON_Limits limits;
+	size_t i, j;
+	cJSON *item;
+	char *ret;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+	h->limits.max_length = 96;
+	h->limits.max_depth = 3;
+	h->limits.max_members = 4;
+	h->limits.max_elements = 3;
+	h->limits.max_string = 8;
+
+	for (i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+		h->flags = flags[i];
+		for (j = 0; j < sizeof(refused) / sizeof(refused[0]); j++) {
+			ret = cjrpc2_handle_request(h, refused[j]);
+			assert_non_null(ret);
+			assert_string_equal(ret, LIMIT_ERROR);
+			free(ret);
+		}
+
+		ret = cjrpc2_handle_request(h, accepted);
+		assert_non_null(ret);
+		assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"result\":[[1],\"abcdefgh\",3],\"id\":1}");
+		free(ret);
+
+		/* syntax errors are still reported as such */
+		ret = cjrpc2_handle_request(h, "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[1,]");
+		assert_non_null(ret);
+		assert_non_null(strstr(ret, "\"code\":-32700"));
+		free(ret);
+	}
+
+	/* the limits are the handler's, cJSON is unlimited again afterwards */
+	item = cJSON_Parse("[[[[1,2,3,4]]]]");
+	assert_non_null(item);
+	cJSON_Delete(item);
+
+	/* limits of the application are restored after a request */
+	memset(&limits, 0, sizeof(cJSON_Limits));
+	limits.max_elements = 5;
+	cJSON_InitThreadLimits(&limits);
+	h->flags = 0;
+	ret = cjrpc2_handle_request(h, accepted);
+	assert_non_null(ret);
+	free(ret);
+	cJSON_GetThreadLimits(&limits);
+	assert_true(limits.max_elements == 5);
+	assert_true(limits.max_depth == 0);
+	item = cJSON_Parse("[[[[1,2,3,4]]]]");
+	assert_non_null(item);
+	cJSON_Delete(item);
+	assert_null(cJSON_Parse("[1,2,3,4,5,6]"));
+	cJSON_InitThreadLimits(NULL);
+
+	cjrpc2_free_handler(h);
+}
+
+static void test_limits_cursor(void **state)
+{
+	static const char *refused[] = {
+		"{\"jsonrpc\":\"2.0\",\"method\":\"walk\",\"params\":[[[[1]]]],\"id\":1}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"walk\",\"params\":[\"abcdefghi\"],\"id\":1}",
+	};
+	struct cjrpc2_handler *h;
+	cJSON_Cursor cursor;
+	cJSON_Limits limits;
+	size_t i;
+	char *ret;
+
+	(void)state; /* unused */
+
+	memset(&limits, 0, sizeof(cJSON_Limits));
+	limits.max_depth = 1;
+	limits.max_string = 3;
+	cJSON_InitThreadLimits(&limits);
+	cJSON_CursorInit(&cursor, "[[1]]", 5);
+	assert_int_equal(cJSON_CursorNext(&cursor), cJSON_TokenBeginArray);
+	assert_int_equal(cJSON_CursorNext(&cursor), cJSON_TokenError);
+	assert_true(cursor.limit);
+	cJSON_CursorInit(&cursor, "\"abcd\"", 6);
+	assert_int_equal(cJSON_CursorNext(&cursor), cJSON_TokenError);
+	assert_true(cursor.limit);
+	cJSON_CursorFree(&cursor);
+	cJSON_CursorInit(&cursor, "[1,]", 4);
+	assert_int_equal(cJSON_CursorNext(&cursor), cJSON_TokenBeginArray);
+	assert_int_equal(cJSON_CursorNext(&cursor), cJSON_TokenNumber);
+	assert_int_equal(cJSON_CursorNext(&cursor), cJSON_TokenError);
+	assert_false(cursor.limit);
+	cJSON_CursorFree(&cursor);
+	cJSON_InitThreadLimits(NULL);
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+	h->limits.max_depth = 3;
+	h->limits.max_string = 8;
+	h->flags = CJRPC2_FLAG_LAZY_PARAMS;
+
+	/* limits met by the method's cursor are no syntax errors */
+	for (i = 0; i < sizeof(refused) / sizeof(refused[0]); i++) {
+		ret = cjrpc2_handle_request(h, refused[i]);
+		assert_non_null(ret);
+		assert_string_equal(ret, LIMIT_ERROR);
+		free(ret);
+	}
+
+	ret = cjrpc2_handle_request(h, "{\"jsonrpc\":\"2.0\",\"method\":\"walk\",\"params\":[1,]"
+				       ",\"id\":1}");
+	assert_non_null(ret);
+	assert_non_null(strstr(ret, "\"code\":-32700"));
+	free(ret);
+
+	cjrpc2_free_handler(h);
+}
+
+/*******************************************************************************
+ * Test main
+ ******************************************************************************/
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_limits_cjson),
+		cmocka_unit_test(test_limits_handler),
+		cmocka_unit_test(test_limits_cursor),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,262 @@
+/* SPDX-License-Identifier: MIT */
+
+#include <stdarg.h>
+
+#include "cJRPC2.h"
+
+#include <errno.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#define LONG_STRING_SIZE 20000
+
+/*******************************************************************************
+ * Test helpers
+ ******************************************************************************/
+static int impl_echo(const cJSON *params, cJSON **resp)
+{
+	*resp = cJSON_Duplicate(cjrpc2_params(params), cJSON_True);
+
+	return CJRPC2_RET_SUCCESS;
+}
+
+static struct cjrpc2_method methods[] = {
+	{"echo", &impl_echo},
+	{NULL, NULL},
+};
+
+/*******************************************************************************
+ * Test functions
+ ******************************************************************************/
+static void test_stream_bytewise(void **state)
+{
+	static const char *requests[] = {
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[\"}]\",\"\\\"{\",\"\\\\\"],\"id\":1}",
+		"\n [{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":{\"a\":{\"b\":[]}},\"id\":2}]",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":{\"x\":\"\\u00e4\"},\"id\":3}",
+	};
+	struct cjrpc2_handler *h;
+	struct cjrpc2_stream s;
+	char *ret, *expected;
+	size_t i, j, len;
+	int ready;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+	cjrpc2_stream_init(&s);
+
+	for (i = 0; i < sizeof(requests) / sizeof(requests[0]); i++) {
+		len = strlen(requests[i]);
+		for (j = 0; j < len; j++) {
+			ready = cjrpc2_stream_feed(&s, &requests[i][j], 1);
+			assert_int_equal(ready, j == len - 1);
+			if (!ready) {
+				errno = 0;
+				assert_null(cjrpc2_stream_handle(h, &s));
+				assert_int_equal(errno, EAGAIN);
+			}
+		}
+		/* same as in one piece */
+		expected = cjrpc2_handle_request(h, requests[i]);
+		assert_non_null(expected);
+		ret = cjrpc2_stream_handle(h, &s);
+		assert_non_null(ret);
+		assert_string_equal(ret, expected);
+		free(expected);
+		free(ret);
+	}
+	assert_int_equal(s.len, 0);
+
+	cjrpc2_stream_free(&s);
+	cjrpc2_free_handler(h);
+}
+
+static void test_stream_pipelined(void **state)
+{
+	static const char *requests =
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[1],\"id\":1}"
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[2],\"id\":2}\r\n"
+		"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[3],\"id\":3}{\"jsonrpc\"";
+	struct cjrpc2_handler *h;
+	struct cjrpc2_stream s;
+	char *ret;
+	int i;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+	cjrpc2_stream_init(&s);
+
+	assert_int_equal(cjrpc2_stream_feed(&s, requests, strlen(requests)), 1);
+	/* without a handler the request stays in the stream */
+	errno = 0;
+	assert_null(cjrpc2_stream_handle(NULL, &s));
+	assert_int_equal(errno, EINVAL);
+	for (i = 1; i <= 3; i++) {
+		ret = cjrpc2_stream_handle(h, &s);
+		assert_non_null(ret);
+		assert_non_null(strstr(ret, "\"result\":["));
+		assert_int_equal(ret[strlen("{\"jsonrpc\":\"2.0\",\"result\":[")] - '0', i);
+		free(ret);
+	}
+	errno = 0;
+	assert_null(cjrpc2_stream_handle(h, &s));
+	assert_int_equal(errno, EAGAIN);
+	assert_int_equal(s.len, strlen("{\"jsonrpc\""));
+
+	cjrpc2_stream_free(&s);
+	cjrpc2_free_handler(h);
+}
+
+static void test_stream_space(void **state)
+{
+	struct cjrpc2_handler *h;
+	struct cjrpc2_stream s;
+	char *req, *ret, *expected, *space;
+	size_t len, off, size, n;
+	int ready;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+	cjrpc2_stream_init(&s);
+
+	req = (char *)malloc(LONG_STRING_SIZE + 100);
+	assert_non_null(req);
+	strcpy(req, "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[\"");
+	len = strlen(req);
+	memset(req + len, '{', LONG_STRING_SIZE);
+	strcpy(req + len + LONG_STRING_SIZE, "\"],\"id\":1}");
+	len = strlen(req);
+
+	/* receive directly into the stream in odd sized pieces */
+	for (off = 0, ready = 0; off < len; off += n) {
+		space = cjrpc2_stream_space(&s, &size);
+		assert_non_null(space);
+		assert_true(size >= CJRPC2_STREAM_CHUNK_SIZE);
+		n = len - off < 1000 ? len - off : 1000;
+		memcpy(space, req + off, n);
+		assert_int_equal(ready, 0);
+		ready = cjrpc2_stream_commit(&s, n);
+	}
+	assert_int_equal(ready, 1);
+
+	expected = cjrpc2_handle_request(h, req);
+	assert_non_null(expected);
+	ret = cjrpc2_stream_handle(h, &s);
+	assert_non_null(ret);
+	assert_string_equal(ret, expected);
+	free(expected);
+	free(ret);
+	free(req);
+
+	assert_int_equal(cjrpc2_stream_commit(&s, s.size + 1), -1);
+	assert_int_equal(errno, EINVAL);
+
+	cjrpc2_stream_free(&s);
+	cjrpc2_free_handler(h);
+}
+
+static void test_stream_malformed(void **state)
+{
+	static const char *requests = "  \"jsonrpc\"{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"id\":1}";
+	struct cjrpc2_handler *h;
+	struct cjrpc2_stream s;
+	char *ret;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+	cjrpc2_stream_init(&s);
+
+	/* a request has to be an object or array, the rest can't be split into requests */
+	assert_int_equal(cjrpc2_stream_feed(&s, requests, strlen(requests)), 1);
+	ret = cjrpc2_stream_handle(h, &s);
+	assert_non_null(ret);
+	assert_string_equal(ret, "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":-32700,\"message\":"
+				 "\"parse error\"},\"id\":null}");
+	free(ret);
+
+	errno = 0;
+	assert_null(cjrpc2_stream_handle(h, &s));
+	assert_int_equal(errno, EPROTO);
+	assert_int_equal(cjrpc2_stream_feed(&s, "{}", 2), -1);
+	assert_int_equal(errno, EPROTO);
+
+	/* a new stream starts over */
+	cjrpc2_stream_free(&s);
+	assert_int_equal(cjrpc2_stream_feed(&s, "{}", 2), 1);
+
+	cjrpc2_stream_free(&s);
+	cjrpc2_free_handler(h);
+}
+
+static void test_stream_max_len(void **state)
+{
+	static const char *request = "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"id\":1}";
+	struct cjrpc2_handler *h;
+	struct cjrpc2_stream s;
+	size_t i, size;
+	char *ret;
+
+	(void)state; /* unused */
+
+	h = cjrpc2_new_handler(methods);
+	assert_non_null(h);
+	cjrpc2_stream_init(&s);
+	s.max_len = strlen(request);
+
+	/* requests up to max_len pass */
+	assert_int_equal(cjrpc2_stream_feed(&s, request, strlen(request)), 1);
+	ret = cjrpc2_stream_handle(h, &s);
+	assert_non_null(ret);
+	free(ret);
+
+	/* a longer one is refused before it is complete, however it is received */
+	assert_int_equal(cjrpc2_stream_feed(&s, "[", 1), 0);
+	for (i = 0; i < LONG_STRING_SIZE; i++) {
+		if (cjrpc2_stream_feed(&s, " ", 1) < 0) {
+			break;
+		}
+	}
+	assert_int_equal(errno, EMSGSIZE);
+	assert_true(i < s.max_len);
+	assert_non_null(cjrpc2_stream_space(&s, &size));
+	assert_true(s.size <= 2 * CJRPC2_STREAM_CHUNK_SIZE);
+
+	/* the stream is broken from then on */
+	errno = 0;
+	assert_null(cjrpc2_stream_handle(h, &s));
+	assert_int_equal(errno, EPROTO);
+	assert_int_equal(cjrpc2_stream_feed(&s, "]", 1), -1);
+	assert_int_equal(errno, EPROTO);
+
+	cjrpc2_stream_free(&s);
+	cjrpc2_free_handler(h);
+}
+
+/*******************************************************************************
+ * Test main
+ ******************************************************************************/
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_stream_bytewise),
+		cmocka_unit_test(test_stream_pipelined),
+		cmocka_unit_test(test_stream_space),
+		cmocka_unit_test(test_stream_malformed),
+		cmocka_unit_test(test_stream_max_len),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
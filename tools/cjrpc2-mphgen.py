@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""Generate a cJRPC2 minimal perfect-hash method table.
+
+usage: cjrpc2-mphgen.py <input.methods> <output.c> <output.h>
+
+The input lists one method per line as "<method name> <C function>", empty
+lines and lines starting with '#' are ignored. The generated table is named
+cjrpc2_table_<input basename> and is meant to be passed to
+cjrpc2_new_handler_static().
+"""
+
+import os
+import re
+import sys
+
+MAX_DISPLACEMENT = 1 << 24
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in data:
+        h ^= b
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def mix(h):
+    # must match cjrpc2_mph_mix() in src/cJRPC2.c
+    h ^= h >> 16
+    h = (h * 0x85EBCA6B) & 0xFFFFFFFF
+    h ^= h >> 13
+    h = (h * 0xC2B2AE35) & 0xFFFFFFFF
+    h ^= h >> 16
+    return h
+
+
+def c_string(s):
+    out = '"'
+    for b in s.encode('utf-8'):
+        c = chr(b)
+        if c in '"\\':
+            out += '\\' + c
+        elif 32 <= b < 127:
+            out += c
+        else:
+            out += '\\%03o' % b
+    return out + '"'
+
+
+def parse(path):
+    methods = []
+    names = set()
+    with open(path, encoding='utf-8') as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.strip()
+            if not line or line.startswith('#'):
+                continue
+            fields = line.split()
+            if len(fields) != 2 or not re.match(r'^[A-Za-z_][A-Za-z0-9_]*$', fields[1]):
+                sys.exit('%s:%d: expected "<method name> <C function>"' % (path, lineno))
+            if fields[0] in names:
+                sys.exit('%s:%d: duplicate method "%s"' % (path, lineno, fields[0]))
+            names.add(fields[0])
+            methods.append((fields[0], fields[1], fnv1a(fields[0].encode('utf-8'))))
+    return methods
+
+
+def build(methods, nbuckets):
+    """hash and displace: returns (displacements, slots) or None"""
+    n = len(methods)
+    buckets = [[] for _ in range(nbuckets)]
+    for m in methods:
+        buckets[m[2] & (nbuckets - 1)].append(m)
+
+    disp = [0] * nbuckets
+    slots = [None] * n
+    for b in sorted(range(nbuckets), key=lambda b: -len(buckets[b])):
+        if not buckets[b]:
+            continue
+        for d in range(MAX_DISPLACEMENT):
+            pos = [mix(m[2] ^ d) % n for m in buckets[b]]
+            if len(set(pos)) == len(pos) and all(slots[p] is None for p in pos):
+                break
+        else:
+            return None
+        disp[b] = d
+        for m, p in zip(buckets[b], pos):
+            slots[p] = m
+    return disp, slots
+
+
+def main():
+    if len(sys.argv) != 4:
+        sys.exit(__doc__.strip())
+    src, out_c, out_h = sys.argv[1:]
+    base = re.sub(r'[^A-Za-z0-9_]', '_', os.path.splitext(os.path.basename(src))[0])
+    table = 'cjrpc2_table_' + base
+    guard = 'CJRPC2_TABLE_%s__H' % base.upper()
+
+    methods = parse(src)
+    hashes = {}
+    for m in methods:
+        if m[2] in hashes:
+            sys.exit('%s: methods "%s" and "%s" have the same hash' % (src, hashes[m[2]], m[0]))
+        hashes[m[2]] = m[0]
+
+    nbuckets = 1
+    while nbuckets * 4 < len(methods):
+        nbuckets <<= 1
+    result = build(methods, nbuckets) if methods else ([0], [])
+    while result is None:
+        nbuckets <<= 1
+        result = build(methods, nbuckets)
+    disp, slots = result
+
+    with open(out_h, 'w', encoding='utf-8') as f:
+        f.write('/* generated by cjrpc2-mphgen.py from %s, do not edit */\n' % os.path.basename(src))
+        f.write('#ifndef %s\n#define %s\n\n#include "cJRPC2.h"\n\n' % (guard, guard))
+        f.write('extern const struct cjrpc2_static_table %s;\n\n#endif\n' % table)
+
+    with open(out_c, 'w', encoding='utf-8') as f:
+        f.write('/* generated by cjrpc2-mphgen.py from %s, do not edit */\n' % os.path.basename(src))
+        f.write('#include "%s"\n\n' % os.path.basename(out_h))
+        for func in sorted(set(m[1] for m in methods)):
+            f.write('int %s(const cJSON *params, cJSON **resp);\n' % func)
+        f.write('\nstatic const struct cjrpc2_method_entry entries[] = {\n')
+        for m in slots:
+            f.write('\t{0x%08xu, %d, %s, &%s},\n'
+                    % (m[2], len(m[0].encode('utf-8')), c_string(m[0]), m[1]))
+        if not slots:
+            f.write('\t{0, 0, NULL, NULL},\n')
+        f.write('};\n\n')
+        f.write('static const uint32_t displacements[] = {\n')
+        for i in range(0, len(disp), 8):
+            f.write('\t' + ' '.join('%uu,' % d for d in disp[i:i + 8]) + '\n')
+        f.write('};\n\n')
+        f.write('const struct cjrpc2_static_table %s = {\n' % table)
+        wildcards = sum(1 for m in methods if m[0] == '*' or m[0].endswith('.*'))
+        f.write('\tentries,\n\t%d,\n\tdisplacements,\n\t%d,\n\t%d,\n};\n'
+                % (len(slots), nbuckets - 1, wildcards))
+
+
+if __name__ == '__main__':
+    main()